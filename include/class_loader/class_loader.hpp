@@ -32,18 +32,27 @@
 #ifndef CLASS_LOADER__CLASS_LOADER_HPP_
 #define CLASS_LOADER__CLASS_LOADER_HPP_
 
-#include <boost/bind.hpp>
+#include <boost/align/aligned_alloc.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#include "console_bridge/console.h"
-
 #include "class_loader/class_loader_core.hpp"
+#include "class_loader/logging.hpp"
 #include "class_loader/register_macro.hpp"
 #include "class_loader/visibility_control.hpp"
 
@@ -71,6 +80,14 @@ std::string systemLibrarySuffix();
 CLASS_LOADER_PUBLIC
 std::string systemLibraryFormat(const std::string & library_name);
 
+template<class Base>
+class FactoryHandle;  // Forward declaration
+
+/**
+ * @brief Compact identifier of a class name, @see ClassLoader::getClassId()
+ */
+typedef impl::SymbolId ClassId;
+
 /**
  * @class ClassLoader
  * @brief This class allows loading and unloading of dynamically linked libraries which contain class definitions from which objects can be created/destroyed during runtime (i.e. class_loader). Libraries loaded by a ClassLoader are only accessible within scope of that ClassLoader object.
@@ -78,8 +95,56 @@ std::string systemLibraryFormat(const std::string & library_name);
 class ClassLoader
 {
 public:
+  /**
+   * @brief Deleter of the smart pointers to plugin objects handed out by a ClassLoader, which destroys the object and accounts for it with the ClassLoader that created it.
+   *
+   * Unlike a bound std::function it does not allocate and keeps std::unique_ptr small.
+   */
+  template<typename Base>
+  class Deleter
+  {
+public:
+    Deleter()
+    : loader_(nullptr), factory_(0)
+    {
+    }
+
+    /**
+     * @param loader - The ClassLoader that created the objects
+     * @param factory - The factory that created the objects, nullptr if unknown
+     * @param pooled - Indicates if the objects are in pooled storage (@see createPooledSharedInstance()) rather than allocated with new
+     */
+    explicit Deleter(
+      ClassLoader * loader, impl::AbstractMetaObjectBase * factory = nullptr, bool pooled = false)
+    : loader_(loader), factory_(reinterpret_cast<uintptr_t>(factory) | (pooled ? 1 : 0))
+    {
+      static_assert(
+        alignof(std::max_align_t) >= 2, "The lowest bit of a factory address must be free");
+      assert(0 == (reinterpret_cast<uintptr_t>(factory) & 1));
+    }
+
+    void operator()(Base * obj) const
+    {
+      impl::AbstractMetaObjectBase * factory =
+        reinterpret_cast<impl::AbstractMetaObjectBase *>(factory_ & ~static_cast<uintptr_t>(1));
+      if (0 == (factory_ & 1)) {
+        loader_->onPluginDeletion<Base>(factory, obj);
+      } else {
+        loader_->onPooledPluginDeletion<Base>(factory, obj);
+      }
+    }
+
+private:
+    ClassLoader * loader_;
+    // Note: The lowest bit of the factory address, which is always 0 as factories are stored in
+    // metaobject arena slots aligned to alignof(std::max_align_t) (@see
+    // impl::allocateMetaObjectStorage()), flags pooled objects so that the deleter stays two
+    // pointers large.
+    uintptr_t factory_;
+  };
+
   template<typename Base>
-  using DeleterType = std::function<void(Base *)>;
+  using DeleterType = Deleter<Base>;
 
   template<typename Base>
   using UniquePtr = std::unique_ptr<Base, DeleterType<Base>>;
@@ -88,9 +153,12 @@ public:
    * @brief  Constructor for ClassLoader
    * @param library_path - The path of the runtime library to load
    * @param ondemand_load_unload - Indicates if on-demand (lazy) unloading/loading of libraries occurs as plugins are created/destroyed
+   * @param load_flags - A combination of LibraryLoadFlags the library is opened with, unless it is open already
    */
   CLASS_LOADER_PUBLIC
-  explicit ClassLoader(const std::string & library_path, bool ondemand_load_unload = false);
+  explicit ClassLoader(
+    const std::string & library_path, bool ondemand_load_unload = false,
+    int load_flags = LIBRARY_LOAD_DEFAULT);
 
   /**
    * @brief  Destructor for ClassLoader. All libraries opened by this ClassLoader are unloaded automatically.
@@ -100,20 +168,59 @@ public:
 
   /**
    * @brief  Indicates which classes (i.e. class_loader) that can be loaded by this object
+   *
+   * In "On Demand Load/Unload" mode, if the library is not loaded yet but has a manifest
+   * (@see class_loader_generate_manifest() CMake function) or an entry in the plugin catalog
+   * (@see impl::setPluginCatalogDirectory()), the classes are read from the manifest rather
+   * than loading the library.
+   *
    * @return vector of strings indicating names of instantiable classes derived from <Base>
    */
   template<class Base>
   std::vector<std::string> getAvailableClasses()
   {
+    std::vector<std::string> manifest_classes;
+    if (isOnDemandLoadUnloadEnabled() && !isLibraryLoaded() &&
+      class_loader::impl::getManifestClassesForLibrary(
+        getLibraryPath(), typeid(Base).name(), manifest_classes))
+    {
+      return manifest_classes;
+    }
     return class_loader::impl::getAvailableClasses<Base>(this);
   }
 
+  /**
+   * @brief  Invokes a callback with the name of each class derived from <Base> that can be loaded by this object, same as getAvailableClasses() but without copying the names into a vector. The classes are visited in no particular order.
+   * @param callback - Invoked as callback(const std::string & class_name), the name is only valid during the call. The callback must not wait for other threads using the plugin system.
+   */
+  template<class Base, typename Callback>
+  void forEachAvailableClass(Callback && callback)
+  {
+    if (isOnDemandLoadUnloadEnabled() && !isLibraryLoaded() &&
+      class_loader::impl::forEachManifestClassForLibrary(
+        getLibraryPath(), typeid(Base).name(), std::ref(callback)))
+    {
+      return;
+    }
+    class_loader::impl::forEachAvailableClass<Base>(this, callback);
+  }
+
   /**
    * @brief Gets the full-qualified path and name of the library associated with this class loader
    */
   CLASS_LOADER_PUBLIC
   std::string getLibraryPath() {return library_path_;}
 
+  /**
+   * @brief Gets the ID of a class name, with which instances of the class can be created without the registry looking up the name on every call. IDs are the same for all ClassLoaders and stay valid for the lifetime of the process, even if the class is not available (yet).
+   * @param class_name - the name of the plugin class
+   * @return The ID of the class name
+   */
+  static ClassId getClassId(const std::string & class_name)
+  {
+    return class_loader::impl::internSymbol(class_name);
+  }
+
   /**
    * @brief  Generates an instance of loadable classes (i.e. class_loader).
    *
@@ -126,9 +233,144 @@ public:
   template<class Base>
   std::shared_ptr<Base> createSharedInstance(const std::string & derived_class_name)
   {
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * obj = createRawInstance<Base>(derived_class_name, true, factory);
+    return std::shared_ptr<Base>(obj, DeleterType<Base>(this, factory));
+  }
+
+  /**
+   * @brief  Same as createSharedInstance() but takes the ID of the class name (@see getClassId()).
+   */
+  template<class Base>
+  std::shared_ptr<Base> createSharedInstance(ClassId derived_class_id)
+  {
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * obj = createRawInstance<Base>(derived_class_id, true, factory);
+    return std::shared_ptr<Base>(obj, DeleterType<Base>(this, factory));
+  }
+
+  /**
+   * @brief  Generates an instance of a class registered with constructor arguments (@see CLASS_LOADER_REGISTER_CLASS_WITH_ARGS), forwarding the arguments to its constructor so that the object is built at once rather than default constructed and then configured. The factory is looked up by the decayed types of the arguments, which have to be the types the class was registered with: rvalues are moved into the constructor, lvalues copied.
+   * @param  derived_class_name The name of the class we want to create
+   * @param  args The constructor arguments
+   * @return A std::shared_ptr<Base> to newly created plugin object
+   */
+  template<class Base, class ... Args>
+  std::shared_ptr<Base>
+  createSharedInstance(const std::string & derived_class_name, Args && ... args)
+  {
+    impl::AbstractMetaObject<Base, typename std::decay<Args>::type...> * factory = nullptr;
+    Base * obj = createRawInstanceWithArgs<Base>(
+      derived_class_name, true, factory, std::forward<Args>(args)...);
+    return std::shared_ptr<Base>(obj, DeleterType<Base>(this, factory));
+  }
+
+  /**
+   * @brief  Generates instances of several loadable classes at once, resolving each factory and loading the library only once for all of them.
+   * @param  derived_class_names The names of the classes we want to create (@see getAvailableClasses()), one instance is created per name
+   * @param  num_threads The number of threads to spread the construction of the instances across, which only pays off for heavy constructors
+   * @return The std::shared_ptr<Base>s to the newly created plugin objects, in the order of the names. If any instance cannot be created, none is returned and the exception is rethrown.
+   */
+  template<class Base>
+  std::vector<std::shared_ptr<Base>> createSharedInstances(
+    const std::vector<std::string> & derived_class_names, size_t num_threads = 1)
+  {
+    return createSharedInstances<Base>(
+      derived_class_names, std::vector<size_t>(derived_class_names.size(), 1), num_threads);
+  }
+
+  /**
+   * @brief  Same as createSharedInstances() but creates a number of instances per class.
+   * @param  derived_class_names The names of the classes we want to create (@see getAvailableClasses())
+   * @param  counts The number of instances to create of each class, in the order of the names
+   * @param  num_threads The number of threads to spread the construction of the instances across
+   * @return The std::shared_ptr<Base>s to the newly created plugin objects, the instances of each class following those of the classes before it
+   */
+  template<class Base>
+  std::vector<std::shared_ptr<Base>> createSharedInstances(
+    const std::vector<std::string> & derived_class_names, const std::vector<size_t> & counts,
+    size_t num_threads = 1)
+  {
+    if (derived_class_names.size() != counts.size()) {
+      throw class_loader::CreateClassException(
+              "Could not create instances as the numbers of class names and counts differ");
+    }
+
+    // Note: Holding a plugin reference keeps the library loaded while the factories are
+    // resolved, and lets the instances take their references without locking
+    acquirePluginReference();
+    std::vector<impl::AbstractMetaObject<Base> *> factories;
+    try {
+      for (size_t i = 0; i < derived_class_names.size(); ++i) {
+        factories.insert(factories.end(), counts[i],
+          class_loader::impl::getFactoryForClass<Base>(derived_class_names[i], this));
+      }
+    } catch (...) {
+      releasePluginReference();
+      throw;
+    }
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader.ClassLoader: Creating %zu instances of %zu classes on %zu threads.",
+      factories.size(), derived_class_names.size(), num_threads);
+
+    std::vector<std::shared_ptr<Base>> instances(factories.size());
+    try {
+      class_loader::impl::runConcurrently(factories.size(), num_threads, [&](size_t i) {
+          ++plugin_ref_count_;
+          Base * obj = nullptr;
+          try {
+            obj = factories[i]->create();
+          } catch (...) {
+            releasePluginReference();
+            throw;
+          }
+          instances[i] = std::shared_ptr<Base>(obj, DeleterType<Base>(this, factories[i]));
+        });
+    } catch (...) {
+      instances.clear();
+      releasePluginReference();
+      throw;
+    }
+    releasePluginReference();
+    return instances;
+  }
+
+  /**
+   * @brief  Generates an instance of loadable classes (i.e. class_loader), allocating the plugin object and the shared pointer control block at once like std::allocate_shared().
+   *
+   * This saves one allocation per instance over createSharedInstance(), but the memory of the
+   * plugin object is only freed once no std::weak_ptr refers to it anymore.
+   *
+   * @param  derived_class_name The name of the class we want to create (@see getAvailableClasses())
+   * @return A std::shared_ptr<Base> to newly created plugin object
+   */
+  template<class Base>
+  std::shared_ptr<Base> allocateSharedInstance(const std::string & derived_class_name)
+  {
+    const SharedControlBlockLayout & layout = getSharedControlBlockLayout<Base>();
+    void * block = nullptr;
+    Base * obj = nullptr;
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    acquirePluginReference();
+    try {
+      factory = class_loader::impl::getFactoryForClass<Base>(derived_class_name, this);
+
+      // The control block goes first, followed by the plugin object at its alignment
+      size_t alignment = std::max(layout.alignment, factory->getClassAlignment());
+      size_t offset = (layout.size + alignment - 1) / alignment * alignment;
+      block = boost::alignment::aligned_alloc(alignment, offset + factory->getClassSize());
+      if (nullptr == block) {
+        throw std::bad_alloc();
+      }
+      obj = factory->create(static_cast<char *>(block) + offset);
+    } catch (...) {
+      boost::alignment::aligned_free(block);
+      releasePluginReference();
+      throw;
+    }
     return std::shared_ptr<Base>(
-      createRawInstance<Base>(derived_class_name, true),
-      boost::bind(&ClassLoader::onPluginDeletion<Base>, this, _1));
+      obj, InplaceDeleter<Base>(this, factory),
+      SharedInstanceAllocator<Base>(block, layout.size));
   }
 
   /**
@@ -139,9 +381,20 @@ public:
   template<class Base>
   boost::shared_ptr<Base> createInstance(const std::string & derived_class_name)
   {
-    return boost::shared_ptr<Base>(
-      createRawInstance<Base>(derived_class_name, true),
-      boost::bind(&ClassLoader::onPluginDeletion<Base>, this, _1));
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * obj = createRawInstance<Base>(derived_class_name, true, factory);
+    return boost::shared_ptr<Base>(obj, DeleterType<Base>(this, factory));
+  }
+
+  /**
+   * @brief  Same as createInstance() but takes the ID of the class name (@see getClassId()).
+   */
+  template<class Base>
+  boost::shared_ptr<Base> createInstance(ClassId derived_class_id)
+  {
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * obj = createRawInstance<Base>(derived_class_id, true, factory);
+    return boost::shared_ptr<Base>(obj, DeleterType<Base>(this, factory));
   }
 
   /**
@@ -159,10 +412,32 @@ public:
   template<class Base>
   UniquePtr<Base> createUniqueInstance(const std::string & derived_class_name)
   {
-    Base * raw = createRawInstance<Base>(derived_class_name, true);
-    return std::unique_ptr<Base, DeleterType<Base>>(
-      raw,
-      boost::bind(&ClassLoader::onPluginDeletion<Base>, this, _1));
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * raw = createRawInstance<Base>(derived_class_name, true, factory);
+    return std::unique_ptr<Base, DeleterType<Base>>(raw, DeleterType<Base>(this, factory));
+  }
+
+  /**
+   * @brief  Same as createUniqueInstance() but takes the ID of the class name (@see getClassId()).
+   */
+  template<class Base>
+  UniquePtr<Base> createUniqueInstance(ClassId derived_class_id)
+  {
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * raw = createRawInstance<Base>(derived_class_id, true, factory);
+    return std::unique_ptr<Base, DeleterType<Base>>(raw, DeleterType<Base>(this, factory));
+  }
+
+  /**
+   * @brief  Same as createSharedInstance() with constructor arguments except it returns a std::unique_ptr.
+   */
+  template<class Base, class ... Args>
+  UniquePtr<Base> createUniqueInstance(const std::string & derived_class_name, Args && ... args)
+  {
+    impl::AbstractMetaObject<Base, typename std::decay<Args>::type...> * factory = nullptr;
+    Base * raw = createRawInstanceWithArgs<Base>(
+      derived_class_name, true, factory, std::forward<Args>(args)...);
+    return std::unique_ptr<Base, DeleterType<Base>>(raw, DeleterType<Base>(this, factory));
   }
 
   /**
@@ -180,21 +455,102 @@ public:
   template<class Base>
   Base * createUnmanagedInstance(const std::string & derived_class_name)
   {
-    return createRawInstance<Base>(derived_class_name, false);
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    return createRawInstance<Base>(derived_class_name, false, factory);
+  }
+
+  /**
+   * @brief  Same as createUnmanagedInstance() but takes the ID of the class name (@see getClassId()).
+   */
+  template<class Base>
+  Base * createUnmanagedInstance(ClassId derived_class_id)
+  {
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    return createRawInstance<Base>(derived_class_id, false, factory);
+  }
+
+  /**
+   * @brief  Generates an instance of loadable classes (i.e. class_loader) in storage taken from a
+   * per-class pool owned by this ClassLoader.
+   *
+   * When the instance is destroyed its storage goes back to the pool and is reused by the next
+   * pooled instance of the same class, which saves heap churn for short-lived plugin objects.
+   * Pooled storage is freed before the library is unloaded and when the ClassLoader is destroyed.
+   *
+   * @param  derived_class_name The name of the class we want to create (@see getAvailableClasses())
+   * @return A std::shared_ptr<Base> to newly created plugin object
+   */
+  template<class Base>
+  std::shared_ptr<Base> createPooledSharedInstance(const std::string & derived_class_name)
+  {
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * obj = createPooledRawInstance<Base>(derived_class_name, factory);
+    return std::shared_ptr<Base>(obj, DeleterType<Base>(this, factory, true));
+  }
+
+  /**
+   * @brief  Generates an instance of loadable classes (i.e. class_loader) in pooled storage.
+   *
+   * Same as createPooledSharedInstance() except it returns a std::unique_ptr.
+   */
+  template<class Base>
+  UniquePtr<Base> createPooledUniqueInstance(const std::string & derived_class_name)
+  {
+    impl::AbstractMetaObject<Base> * factory = nullptr;
+    Base * obj = createPooledRawInstance<Base>(derived_class_name, factory);
+    return UniquePtr<Base>(obj, DeleterType<Base>(this, factory, true));
   }
 
   /**
-   * @brief Indicates if a plugin class is available
-   * @param Base - polymorphic type indicating base class
+   * @brief  Resolves the factory of a loadable class once and returns a handle to it, which can then be used to cheaply and repeatedly generate instances of the class.
+   *
+   * It is not necessary for the user to call loadLibrary() as it will be invoked automatically
+   * if the library is not yet loaded (which typically happens when in "On Demand Load/Unload" mode).
+   *
+   * @param  derived_class_name The name of the class we want to create (@see getAvailableClasses())
+   * @return A FactoryHandle<Base> bound to the factory of the class
+   */
+  template<class Base>
+  FactoryHandle<Base> getFactory(const std::string & derived_class_name)
+  {
+    FactoryHandle<Base> handle(this, derived_class_name);
+    resolveFactory<Base>(handle);
+    return handle;
+  }
+
+  /**
+   * @brief Indicates if a plugin class is available. In "On Demand Load/Unload" mode, if the library is not loaded yet, the class is looked up in its manifest (@see getAvailableClasses()), and the library is only opened (and closed again) if the manifest does not list the class.
+   * @param Base - polymorphic type indicating base class, or the signature Base(Args...) for a class constructed from arguments (@see CLASS_LOADER_REGISTER_CLASS_WITH_ARGS)
    * @param class_name - the name of the plugin class
    * @return true if yes it is available, false otherwise
    */
   template<class Base>
   bool isClassAvailable(const std::string & class_name)
   {
-    std::vector<std::string> available_classes = getAvailableClasses<Base>();
-    return std::find(
-      available_classes.begin(), available_classes.end(), class_name) != available_classes.end();
+    bool available = false;
+    // Note: Manifests do not list classes constructed from arguments, whose Base is a signature
+    if (!std::is_function<Base>::value && isOnDemandLoadUnloadEnabled() && !isLibraryLoaded() &&
+      class_loader::impl::forEachManifestClassForLibrary(
+        getLibraryPath(), typeid(Base).name(),
+        [&available, &class_name](const std::string & manifest_class_name) {
+          available = available || manifest_class_name == class_name;
+        }))
+    {
+      if (available) {
+        return true;
+      }
+      // Note: The manifest misses classes registered in ways its generator does not recognize, so
+      // the library is opened to look for the class. Holding the mutex keeps instances from being
+      // created meanwhile, so that the library can be closed again.
+      boost::recursive_mutex::scoped_lock lock(load_ref_count_mutex_);
+      if (!isLibraryLoaded()) {
+        loadLibrary();
+        available = class_loader::impl::isClassAvailable<Base>(class_name, this);
+        unloadLibrary();
+        return available;
+      }
+    }
+    return class_loader::impl::isClassAvailable<Base>(class_name, this);
   }
 
   /**
@@ -218,6 +574,37 @@ public:
   CLASS_LOADER_PUBLIC
   bool isOnDemandLoadUnloadEnabled() {return ondemand_load_unload_;}
 
+  /**
+   * @brief Gets the LibraryLoadFlags the library is opened with, @see ClassLoader()
+   */
+  CLASS_LOADER_PUBLIC
+  int getLibraryLoadFlags() {return load_flags_;}
+
+  /**
+   * @brief Sets how long the library stays loaded in "on-demand load/unload" mode after the last plugin was destroyed. With a grace period, the library is unloaded by a background thread once the period elapsed, unless a plugin is created in the meantime, so that the destroying thread does not pay for the unload and a library needed again right away is not reopened. The default of 0 unloads right away in the destroying thread.
+   * @param grace_period - The grace period
+   */
+  CLASS_LOADER_PUBLIC
+  void setUnloadGracePeriod(std::chrono::steady_clock::duration grace_period);
+
+  /**
+   * @brief Gets the grace period of unloads in "on-demand load/unload" mode, @see setUnloadGracePeriod()
+   */
+  CLASS_LOADER_PUBLIC
+  std::chrono::steady_clock::duration getUnloadGracePeriod();
+
+  /**
+   * @brief Retires the library, which is then unloaded as soon as the last plugin created by this ClassLoader is destroyed, right away if there is none, however many times it was loaded. This is how MultiLibraryClassLoader::reloadLibrary() gets rid of the build it replaced. A plugin created afterwards loads the library again until it is destroyed.
+   */
+  CLASS_LOADER_PUBLIC
+  void retireLibrary();
+
+  /**
+   * @brief Indicates if the library was retired, @see retireLibrary()
+   */
+  CLASS_LOADER_PUBLIC
+  bool isLibraryRetired();
+
   /**
    * @brief  Attempts to load a library on behalf of the ClassLoader. If the library is already opened, this method has no effect. If the library has been already opened by some other entity (i.e. another ClassLoader or global interface), this object is given permissions to access any plugin classes loaded by that other entity. This is
    * @param  library_path The path to the library to load
@@ -225,6 +612,14 @@ public:
   CLASS_LOADER_PUBLIC
   void loadLibrary();
 
+  /**
+   * @brief  Loads the library on a background thread ahead of the first plugin, so that a lazy ClassLoader does not pay for opening the library on the request path. The index the factories are looked up in is rebuilt as well and, optionally, the pages of the library are faulted in (@see impl::prefaultLibrary()). In "on-demand load/unload" mode the library is loaded as if for the first plugin, i.e. it is unloaded again once the plugins created afterwards are destroyed.
+   * @param  prefault_pages Set to true to also fault in the pages of the library
+   * @return A future that becomes ready once done, rethrowing a LibraryLoadException if the library could not be loaded. The ClassLoader waits for it when destroyed.
+   */
+  CLASS_LOADER_PUBLIC
+  std::shared_future<void> prefetch(bool prefault_pages = false);
+
   /**
    * @brief  Attempts to unload a library loaded within scope of the ClassLoader. If the library is not opened, this method has no effect. If the library is opened by other another ClassLoader, the library will NOT be unloaded internally -- however this ClassLoader will no longer be able to instantiate class_loader bound to that library. If there are plugin objects that exist in memory created by this classloader, a warning message will appear and the library will not be unloaded. If loadLibrary() was called multiple times (e.g. in the case of multiple threads or purposefully in a single thread), the user is responsible for calling unloadLibrary() the same number of times. The library will not be unloaded within the context of this classloader until the number of unload calls matches the number of loads.
    * @return The number of times more unloadLibrary() has to be called for it to be unbound from this ClassLoader
@@ -233,49 +628,312 @@ public:
   int unloadLibrary();
 
 private:
+  template<class Base>
+  friend class FactoryHandle;
+
+  /**
+   * @brief Deleter of the plugin objects created by allocateSharedInstance(), which only destroys the object as its memory belongs to the shared pointer control block.
+   */
+  template<typename Base>
+  class InplaceDeleter
+  {
+public:
+    InplaceDeleter(ClassLoader * loader, impl::AbstractMetaObjectBase * factory)
+    : loader_(loader), factory_(factory)
+    {
+    }
+
+    void operator()(Base * obj) const
+    {
+      if (nullptr == obj) {
+        return;
+      }
+      loader_->onInplacePluginDestruction<Base>(factory_, obj);
+    }
+
+private:
+    ClassLoader * loader_;
+    impl::AbstractMetaObjectBase * factory_;
+  };
+
+  /**
+   * @brief Size and alignment of the shared pointer control block of plugin objects created by allocateSharedInstance()
+   */
+  struct SharedControlBlockLayout
+  {
+    size_t size;
+    size_t alignment;
+  };
+
+  /**
+   * @brief Allocator of the shared pointer control block of plugin objects created by allocateSharedInstance(), which hands out the front of the block allocated for the object and frees the whole block along with the control block.
+   *
+   * Without a block it allocates normally and records the layout of the control block, which
+   * is how getSharedControlBlockLayout() finds it out.
+   */
+  template<typename T>
+  class SharedInstanceAllocator
+  {
+public:
+    typedef T value_type;
+
+    SharedInstanceAllocator(void * block, size_t capacity)
+    : block_(block), capacity_(capacity), layout_(nullptr)
+    {
+    }
+
+    explicit SharedInstanceAllocator(SharedControlBlockLayout * layout)
+    : block_(nullptr), capacity_(0), layout_(layout)
+    {
+    }
+
+    template<typename U>
+    SharedInstanceAllocator(const SharedInstanceAllocator<U> & other)  // NOLINT
+    : block_(other.block_), capacity_(other.capacity_), layout_(other.layout_)
+    {
+    }
+
+    T * allocate(size_t n)
+    {
+      if (nullptr == block_) {
+        layout_->size = n * sizeof(T);
+        layout_->alignment = alignof(T);
+        return std::allocator<T>().allocate(n);
+      }
+      if (n * sizeof(T) > capacity_) {
+        throw std::bad_alloc();
+      }
+      return static_cast<T *>(block_);
+    }
+
+    void deallocate(T * p, size_t n)
+    {
+      if (nullptr == block_) {
+        std::allocator<T>().deallocate(p, n);
+      } else {
+        boost::alignment::aligned_free(block_);
+      }
+    }
+
+    template<typename U>
+    bool operator==(const SharedInstanceAllocator<U> & other) const
+    {
+      return block_ == other.block_;
+    }
+
+    template<typename U>
+    bool operator!=(const SharedInstanceAllocator<U> & other) const
+    {
+      return block_ != other.block_;
+    }
+
+private:
+    template<typename U>
+    friend class SharedInstanceAllocator;
+
+    void * block_;
+    size_t capacity_;
+    SharedControlBlockLayout * layout_;
+  };
+
+  /**
+   * @brief Gets the layout of the shared pointer control block allocateSharedInstance() uses for Base, which is found out once by creating an empty shared pointer.
+   */
+  template<class Base>
+  static const SharedControlBlockLayout & getSharedControlBlockLayout()
+  {
+    static const SharedControlBlockLayout layout = []() {
+        SharedControlBlockLayout probed = {0, 0};
+        std::shared_ptr<Base> probe(
+          static_cast<Base *>(nullptr), InplaceDeleter<Base>(nullptr, nullptr),
+          SharedInstanceAllocator<Base>(&probed));
+        return probed;
+      }();
+    return layout;
+  }
+
   /**
    * @brief Callback method when a plugin created by this class loader is destroyed
+   * @param factory - The factory the plugin was created with, nullptr if unknown
    * @param obj - A pointer to the deleted object
    */
   template<class Base>
-  void onPluginDeletion(Base * obj)
+  void onPluginDeletion(impl::AbstractMetaObjectBase * factory, Base * obj)
   {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader::ClassLoader: Calling onPluginDeletion() for obj ptr = %p.\n",
       reinterpret_cast<void *>(obj));
     if (nullptr == obj) {
       return;
     }
-    boost::recursive_mutex::scoped_lock lock(plugin_ref_count_mutex_);
+    impl::ScopedTrace trace(
+      impl::TRACE_INSTANCE_DESTROY, nullptr != factory ? factory->className() : library_path_);
     delete (obj);
-    plugin_ref_count_ = plugin_ref_count_ - 1;
-    assert(plugin_ref_count_ >= 0);
-    if (0 == plugin_ref_count_ && isOnDemandLoadUnloadEnabled()) {
-      if (!ClassLoader::hasUnmanagedInstanceBeenCreated()) {
-        unloadLibraryInternal(false);
-      } else {
-        CONSOLE_BRIDGE_logWarn(
-          "class_loader::ClassLoader: "
-          "Cannot unload library %s even though last shared pointer went out of scope. "
-          "This is because createUnmanagedInstance was used within the scope of this process,"
-          " perhaps by a different ClassLoader. Library will NOT be closed.",
-          getLibraryPath().c_str());
+    if (nullptr != factory) {
+      factory->countDestruction();
+    }
+    releasePluginReference();
+  }
+
+  /**
+   * @brief Callback method when a plugin created in pooled storage by this class loader is destroyed
+   * @param factory - The factory the plugin was created with
+   * @param obj - A pointer to the deleted object
+   */
+  template<class Base>
+  void onPooledPluginDeletion(impl::AbstractMetaObjectBase * factory, Base * obj)
+  {
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader::ClassLoader: Calling onPooledPluginDeletion() for obj ptr = %p.\n",
+      reinterpret_cast<void *>(obj));
+    if (nullptr == obj) {
+      return;
+    }
+    impl::ScopedTrace trace(impl::TRACE_INSTANCE_DESTROY, factory->className());
+    // Note: The storage starts at the most derived object, which obj may be offset from
+    void * storage = dynamic_cast<void *>(obj);
+    obj->~Base();
+    factory->countDestruction();
+    releasePooledStorage(factory, storage);
+    releasePluginReference();
+  }
+
+  /**
+   * @brief Callback method when a plugin created by allocateSharedInstance() is destroyed, its memory is freed afterwards along with the shared pointer control block.
+   * @param factory - The factory the plugin was created with
+   * @param obj - A pointer to the destroyed object
+   */
+  template<class Base>
+  void onInplacePluginDestruction(impl::AbstractMetaObjectBase * factory, Base * obj)
+  {
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader::ClassLoader: Calling onInplacePluginDestruction() for obj ptr = %p.\n",
+      reinterpret_cast<void *>(obj));
+    impl::ScopedTrace trace(impl::TRACE_INSTANCE_DESTROY, factory->className());
+    obj->~Base();
+    factory->countDestruction();
+    releasePluginReference();
+  }
+
+  /**
+   * @brief Counts a managed plugin about to be created, loading the library if needed, which keeps the library from being unloaded until releasePluginReference() is called.
+   *
+   * Only the first plugin takes the mutexes, the others just bump the atomic count. The count is
+   * raised from 0 once the library is loaded, so that it being above 0 means the library is loaded.
+   */
+  CLASS_LOADER_PUBLIC
+  void acquirePluginReference();
+
+  /**
+   * @brief Accounts for the destruction of a managed plugin, unloading the library in "on-demand load/unload" mode if it was the last one.
+   *
+   * Only the last plugin takes the mutexes, the others just drop the atomic count.
+   */
+  CLASS_LOADER_PUBLIC
+  void releasePluginReference();
+
+  /**
+   * @brief  Generates an instance of loadable classes in storage taken from the pool of its class.
+   * @param  derived_class_name The name of the class we want to create (@see getAvailableClasses())
+   * @param  factory Receives the factory the instance was created with
+   * @return A Base* to newly created plugin object
+   */
+  template<class Base>
+  Base * createPooledRawInstance(
+    const std::string & derived_class_name, impl::AbstractMetaObject<Base> * & factory)
+  {
+    acquirePluginReference();
+    try {
+      factory = class_loader::impl::getFactoryForClass<Base>(derived_class_name, this);
+      void * storage = allocatePooledStorage(
+        factory, factory->getClassSize(), factory->getClassAlignment());
+      try {
+        return factory->create(storage);
+      } catch (...) {
+        releasePooledStorage(factory, storage);
+        throw;
       }
+    } catch (...) {
+      releasePluginReference();
+      throw;
     }
   }
 
+  /**
+   * @brief Takes storage for an instance of a class from the pool of its factory, allocating new storage if the pool is empty.
+   * @param factory - The factory of the class
+   * @param size - The size of the class
+   * @param alignment - The alignment of the class
+   * @return The storage
+   */
+  CLASS_LOADER_PUBLIC
+  void * allocatePooledStorage(
+    const impl::AbstractMetaObjectBase * factory, size_t size, size_t alignment);
+
+  /**
+   * @brief Returns storage taken with allocatePooledStorage() to the pool of its factory.
+   */
+  CLASS_LOADER_PUBLIC
+  void releasePooledStorage(const impl::AbstractMetaObjectBase * factory, void * storage);
+
+  /**
+   * @brief Frees all the storage held by the pools, done before the library is unloaded as factories may be destroyed or reused after that.
+   */
+  CLASS_LOADER_PUBLIC
+  void purgePooledStorage();
+
   /**
    * @brief  Generates an instance of loadable classes (i.e. class_loader).
    *
    * It is not necessary for the user to call loadLibrary() as it will be invoked automatically
    * if the library is not yet loaded (which typically happens when in "On Demand Load/Unload" mode).
    *
-   * @param  derived_class_name The name of the class we want to create (@see getAvailableClasses())
+   * @param  derived_class The name of the class we want to create (@see getAvailableClasses()) or its ID (@see getClassId())
    * @param  managed If true, the returned pointer is assumed to be wrapped in a smart pointer by the caller.
+   * @param  factory Receives the factory the instance was created with
    * @return A Base* to newly created plugin object
    */
-  template<class Base>
-  Base * createRawInstance(const std::string & derived_class_name, bool managed)
+  template<class Base, typename ClassKey>
+  Base * createRawInstance(
+    const ClassKey & derived_class, bool managed, impl::AbstractMetaObject<Base> * & factory)
+  {
+    return createCountedInstance<Base>(
+      managed, [&]() {
+        factory = class_loader::impl::getFactoryForClass<Base>(derived_class, this);
+        return factory->create();
+      });
+  }
+
+  /**
+   * @brief  Same as createRawInstance() but constructs the instance from arguments (@see createSharedInstance()).
+   * @param  derived_class_name The name of the class we want to create
+   * @param  managed If true, the returned pointer is assumed to be wrapped in a smart pointer by the caller.
+   * @param  factory Receives the factory the instance was created with
+   * @param  args The constructor arguments
+   * @return A Base* to newly created plugin object
+   */
+  template<class Base, class ... Args>
+  Base * createRawInstanceWithArgs(
+    const std::string & derived_class_name, bool managed,
+    impl::AbstractMetaObject<Base, typename std::decay<Args>::type...> * & factory,
+    Args && ... args)
+  {
+    return createCountedInstance<Base>(
+      managed, [&]() {
+        factory = class_loader::impl::getFactoryForClass<
+          Base, typename std::decay<Args>::type...>(derived_class_name, this);
+        return factory->create(class_loader::impl::forwardConstructorArgument<Args>(args)...);
+      });
+  }
+
+  /**
+   * @brief  Creates an instance with a callback, counting it as a plugin of this ClassLoader if it is managed and loading the library first if needed.
+   * @param  managed If true, the returned pointer is assumed to be wrapped in a smart pointer by the caller.
+   * @param  create Looks up the factory and creates the instance with it
+   * @return A Base* to newly created plugin object
+   */
+  template<class Base, typename Create>
+  Base * createCountedInstance(bool managed, Create && create)
   {
     if (!managed) {
       has_unmananged_instance_been_created_ = true;
@@ -286,7 +944,7 @@ private:
       ClassLoader::hasUnmanagedInstanceBeenCreated() &&
       isOnDemandLoadUnloadEnabled())
     {
-      CONSOLE_BRIDGE_logInform("%s",
+      CLASS_LOADER_LOG_INFORM("%s",
         "class_loader::ClassLoader: "
         "An attempt is being made to create a managed plugin instance (i.e. boost::shared_ptr), "
         "however an unmanaged instance was created within this process address space. "
@@ -294,19 +952,71 @@ private:
         "final plugin destruction if on demand (lazy) loading/unloading mode is used."
       );
     }
+
+    // Counting the instance up front keeps the library from being unloaded by the destruction
+    // of another instance before the new one exists.
+    if (managed) {
+      acquirePluginReference();
+    } else if (!isLibraryLoaded()) {
+      loadLibrary();
+    }
+    try {
+      Base * obj = create();
+      assert(obj != nullptr);  // Unreachable assertion if create() throws on failure
+      return obj;
+    } catch (...) {
+      if (managed) {
+        releasePluginReference();
+      }
+      throw;
+    }
+  }
+
+  /**
+   * @brief Binds a FactoryHandle to the factory of its class, loading the library if needed.
+   * @param handle - The handle to (re)bind
+   */
+  template<class Base>
+  void resolveFactory(FactoryHandle<Base> & handle)
+  {
     if (!isLibraryLoaded()) {
       loadLibrary();
     }
+    // Note: Read the generation before looking up the factory, so that an unload happening in
+    // between is caught by FactoryHandle::isValid() rather than leaving a dangling factory.
+    handle.library_generation_ = library_generation_.load();
+    handle.factory_ = class_loader::impl::getFactoryForClass<Base>(handle.class_name_, this);
+  }
 
-    Base * obj = class_loader::impl::createInstance<Base>(derived_class_name, this);
-    assert(obj != nullptr);  // Unreachable assertion if createInstance() throws on failure
+  /**
+   * @brief  Generates an instance of the class a FactoryHandle resolves to, re-resolving the factory first if the library has been unloaded since.
+   * @param  handle The handle obtained through getFactory()
+   * @param  managed If true, the returned pointer is assumed to be wrapped in a smart pointer by the caller.
+   * @return A Base* to newly created plugin object
+   */
+  template<class Base>
+  Base * createRawInstance(FactoryHandle<Base> & handle, bool managed)
+  {
+    if (!managed) {
+      has_unmananged_instance_been_created_ = true;
+    }
 
+    // Counting the instance up front keeps the library from being unloaded between checking
+    // the handle and invoking its factory.
     if (managed) {
-      boost::recursive_mutex::scoped_lock lock(plugin_ref_count_mutex_);
-      ++plugin_ref_count_;
+      acquirePluginReference();
+    }
+    try {
+      if (!handle.isValid()) {
+        resolveFactory<Base>(handle);
+      }
+      return handle.factory_->create();
+    } catch (...) {
+      if (managed) {
+        releasePluginReference();
+      }
+      throw;
     }
-
-    return obj;
   }
 
   /**
@@ -323,18 +1033,133 @@ private:
   CLASS_LOADER_PUBLIC
   int unloadLibraryInternal(bool lock_plugin_ref_count);
 
+  /**
+   * @brief Unloads the library if still no plugin exists, invoked once the grace period of an unload elapsed (@see setUnloadGracePeriod())
+   */
+  void unloadIdleLibrary();
+
+  /**
+   * @brief Unloads the retired library for good, plugin_ref_count_mutex_ must be locked and no plugin exist (@see retireLibrary())
+   */
+  void unloadRetiredLibrary();
+
 private:
+  friend class impl::AbstractMetaObjectBase;
+
   bool ondemand_load_unload_;
+  int load_flags_;
   std::string library_path_;
-  int load_ref_count_;
+  // The reference counts are atomic so that they can change without locking as long as they do
+  // not drop to or rise from 0. The mutexes guard those transitions, which load or unload the
+  // library. When both are needed load_ref_count_mutex_ is locked first.
+  std::atomic<int> load_ref_count_;
   boost::recursive_mutex load_ref_count_mutex_;
-  int plugin_ref_count_;
+  std::atomic<int> plugin_ref_count_;
   boost::recursive_mutex plugin_ref_count_mutex_;
+  // Incremented every time the library is unloaded, invalidating resolved FactoryHandles
+  std::atomic<size_t> library_generation_;
+  // Guarded by plugin_ref_count_mutex_, the pending flag is set while a deferred unload is
+  // scheduled and not canceled by a new plugin
+  std::chrono::steady_clock::duration unload_grace_period_;
+  bool unload_pending_;
+  // Guarded by plugin_ref_count_mutex_, @see retireLibrary()
+  bool retired_;
+  // Free storage for pooled instances, by factory
+  std::unordered_map<const impl::AbstractMetaObjectBase *, std::vector<void *>> pooled_storage_;
+  boost::recursive_mutex pooled_storage_mutex_;
+  // The bit of this ClassLoader in the owner bitmaps of metaobjects
+  size_t owner_id_;
+  // The last prefetch(), guarded by load_ref_count_mutex_
+  std::shared_future<void> prefetched_;
 
   CLASS_LOADER_PUBLIC
   static bool has_unmananged_instance_been_created_;
 };
 
+/**
+ * @class FactoryHandle
+ * @brief A handle to the factory of one plugin class obtained through ClassLoader::getFactory(). The factory is resolved once, so creating instances through the handle skips the library and class name lookups that ClassLoader::createSharedInstance() and friends go through on every call. If the library is unloaded, the handle notices it and transparently resolves the factory again (loading the library if needed) on next use.
+ *
+ * A FactoryHandle is cheap to copy; give each thread its own copy rather than sharing one. It must not outlive the ClassLoader it was obtained from.
+ */
+template<class Base>
+class FactoryHandle
+{
+public:
+  /**
+   * @brief Constructs a handle not bound to any factory, creating instances through it throws.
+   */
+  FactoryHandle()
+  : loader_(nullptr), factory_(nullptr), library_generation_(0)
+  {
+  }
+
+  /**
+   * @brief Gets the name of the class this handle creates instances of
+   */
+  const std::string & getClassName() const {return class_name_;}
+
+  /**
+   * @brief Indicates if the resolved factory can still be used as is, i.e. the library it came from has not been unloaded by the ClassLoader since it was resolved.
+   * @return true if the factory is resolved and still valid, false otherwise
+   */
+  bool isValid() const
+  {
+    return nullptr != factory_ && library_generation_ == loader_->library_generation_.load();
+  }
+
+  /**
+   * @brief Generates an instance of the class, @see ClassLoader::createSharedInstance()
+   * @return A std::shared_ptr<Base> to newly created plugin object
+   */
+  std::shared_ptr<Base> createShared()
+  {
+    Base * raw = getLoader()->createRawInstance(*this, true);
+    return std::shared_ptr<Base>(raw, ClassLoader::DeleterType<Base>(loader_, factory_));
+  }
+
+  /**
+   * @brief Generates an instance of the class, @see ClassLoader::createUniqueInstance()
+   * @return A std::unique_ptr<Base> to newly created plugin object
+   */
+  ClassLoader::UniquePtr<Base> createUnique()
+  {
+    Base * raw = getLoader()->createRawInstance(*this, true);
+    return ClassLoader::UniquePtr<Base>(raw, ClassLoader::DeleterType<Base>(loader_, factory_));
+  }
+
+  /**
+   * @brief Generates an instance of the class, @see ClassLoader::createUnmanagedInstance()
+   * @return An unmanaged (i.e. not a shared_ptr) Base* to newly created plugin object.
+   */
+  Base * createUnmanaged()
+  {
+    return getLoader()->createRawInstance(*this, false);
+  }
+
+private:
+  friend class ClassLoader;
+
+  FactoryHandle(ClassLoader * loader, const std::string & class_name)
+  : loader_(loader), class_name_(class_name), factory_(nullptr), library_generation_(0)
+  {
+  }
+
+  ClassLoader * getLoader() const
+  {
+    if (nullptr == loader_) {
+      throw class_loader::CreateClassException(
+              "Could not create instance through a factory handle not bound to a ClassLoader");
+    }
+    return loader_;
+  }
+
+  ClassLoader * loader_;
+  std::string class_name_;
+  impl::AbstractMetaObject<Base> * factory_;
+  size_t library_generation_;
+};
+
 }  // namespace class_loader
 
 
@@ -33,24 +33,26 @@
 #define CLASS_LOADER__CLASS_LOADER_CORE_HPP_
 
 #include <boost/thread/recursive_mutex.hpp>
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <map>
 #include <string>
+#include <type_traits>
 #include <typeinfo>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "class_loader/exceptions.hpp"
+#include "class_loader/library_backend.hpp"
 #include "class_loader/meta_object.hpp"
+#include "class_loader/tracer.hpp"
 #include "class_loader/visibility_control.hpp"
 
-// forward declaration
-namespace Poco
-{
-  class SharedLibrary;
-}  // namespace Poco
-
 /**
  * @note This header file is the internal implementation of the plugin system which is exposed via the ClassLoader class
  */
@@ -67,11 +69,67 @@ namespace impl
 typedef std::string LibraryPath;
 typedef std::string ClassName;
 typedef std::string BaseClassName;
-typedef std::map<ClassName, impl::AbstractMetaObjectBase *> FactoryMap;
-typedef std::map<BaseClassName, FactoryMap> BaseToFactoryMapMap;
-typedef std::pair<LibraryPath, Poco::SharedLibrary *> LibraryPair;
-typedef std::vector<LibraryPair> LibraryVector;
+typedef std::map<SymbolId, impl::AbstractMetaObjectBase *> FactoryMap;
+typedef std::map<SymbolId, FactoryMap> BaseToFactoryMapMap;
 typedef std::vector<AbstractMetaObjectBase *> MetaObjectVector;
+typedef uint64_t FactoryKey;
+typedef std::unordered_map<FactoryKey, impl::AbstractMetaObjectBase *> FactoryIndexMap;
+
+/**
+ * @brief The ID no name is interned as, returned by findSymbol() for names never interned
+ */
+const SymbolId kInvalidSymbolId = 0;
+
+/**
+ * @brief A library opened by the plugin system
+ */
+struct LoadedLibrary
+{
+  LibraryHandle handle;
+  /// The backend that opened the library, which also closes it
+  LibraryBackend * backend;
+  /// The LibraryLoadFlags the library was opened with
+  int flags;
+};
+
+typedef std::unordered_map<SymbolId, LoadedLibrary> LibraryMap;
+
+// Symbols
+
+/**
+ * @brief Interns a class, base class or library name, i.e. maps it to a compact ID which is the same for equal names. The registry is keyed by these IDs, so that lookups and comparisons do not hash or compare strings. IDs stay valid for the lifetime of the process, and each thread caches the names it has interned, so interning a known name does not take a lock.
+ * @param name - The name to intern
+ * @return The ID of the name, never kInvalidSymbolId
+ */
+CLASS_LOADER_PUBLIC
+SymbolId internSymbol(const std::string & name);
+
+/**
+ * @brief Same as internSymbol() but does not intern names that are not interned yet
+ * @param name - The name to look up
+ * @return The ID of the name, kInvalidSymbolId if it was never interned
+ */
+CLASS_LOADER_PUBLIC
+SymbolId findSymbol(const std::string & name);
+
+/**
+ * @brief Gets the name an ID was interned for, without taking a lock
+ * @param id - An ID returned by internSymbol()
+ * @return The name, which stays valid for the lifetime of the process (empty for kInvalidSymbolId)
+ */
+CLASS_LOADER_PUBLIC
+const std::string & getSymbolName(SymbolId id);
+
+/**
+ * @brief Gets the interned ID of typeid(Base).name()
+ */
+template<typename Base>
+SymbolId getBaseClassId()
+{
+  // Note: Interned once per base class and module
+  static const SymbolId base_class_id = internSymbol(typeid(Base).name());
+  return base_class_id;
+}
 
 // Debug
 CLASS_LOADER_PUBLIC
@@ -87,21 +145,21 @@ CLASS_LOADER_PUBLIC
 BaseToFactoryMapMap & getGlobalPluginBaseToFactoryMapMap();
 
 /**
- * @brief Gets a handle to a list of open libraries in the form of LibraryPairs which encode the library path+name and the handle to the underlying Poco::SharedLibrary
- * @return A reference to the global vector that tracks loaded libraries
+ * @brief Gets a handle to the table of open libraries, which maps the interned ID of each library path+name to the handle of the library and the backend that opened it. Guarded by getLoadedLibraryVectorMutex().
+ * @return A reference to the global table that tracks loaded libraries
  */
 CLASS_LOADER_PUBLIC
-LibraryVector & getLoadedLibraryVector();
+LibraryMap & getLoadedLibraryMap();
 
 /**
- * @brief When a library is being loaded, in order for factories to know which library they are being associated with, they use this function to query which library is being loaded.
+ * @brief When a library is being loaded, in order for factories to know which library they are being associated with, they use this function to query which library is being loaded by the calling thread.
  * @return The currently set loading library name as a string
  */
 CLASS_LOADER_PUBLIC
 std::string getCurrentlyLoadingLibraryName();
 
 /**
- * @brief When a library is being loaded, in order for factories to know which library they are being associated with, this function is called to set the name of the library currently being loaded.
+ * @brief When a library is being loaded, in order for factories to know which library they are being associated with, this function is called to set the name of the library currently being loaded by the calling thread.
  * @param library_name - The name of library that is being loaded currently
  */
 CLASS_LOADER_PUBLIC
@@ -109,20 +167,47 @@ void setCurrentlyLoadingLibraryName(const std::string & library_name);
 
 
 /**
- * @brief Gets the ClassLoader currently in scope which used when a library is being loaded.
+ * @brief Gets the ClassLoader currently in scope which used when a library is being loaded by the calling thread.
  * @return A pointer to the currently active ClassLoader.
  */
 CLASS_LOADER_PUBLIC
 ClassLoader * getCurrentlyActiveClassLoader();
 
 /**
- * @brief Sets the ClassLoader currently in scope which used when a library is being loaded.
+ * @brief Sets the ClassLoader currently in scope which used when a library is being loaded by the calling thread.
  * @param loader - pointer to the currently active ClassLoader.
  */
 CLASS_LOADER_PUBLIC
 void setCurrentlyActiveClassLoader(ClassLoader * loader);
 
 
+/**
+ * @class ScopedLoadingContext
+ * @brief Sets the library being loaded and the ClassLoader loading it for the calling thread for the lifetime of the object (@see setCurrentlyLoadingLibraryName(), setCurrentlyActiveClassLoader()). The previous ones are restored on destruction, so a library that loads another library from its static initializers still has its own remaining factories attributed to it.
+ */
+class CLASS_LOADER_PUBLIC ScopedLoadingContext
+{
+public:
+  /**
+   * @brief Constructor for the class
+   * @param library_path - The name of library that is being loaded
+   * @param loader - pointer to the ClassLoader loading it
+   */
+  ScopedLoadingContext(const std::string & library_path, ClassLoader * loader);
+
+  /**
+   * @brief Destructor for the class, restores the previous loading context of the thread
+   */
+  ~ScopedLoadingContext();
+
+private:
+  ScopedLoadingContext(const ScopedLoadingContext &);
+  ScopedLoadingContext & operator=(const ScopedLoadingContext &);
+
+  std::string previous_library_name_;
+  ClassLoader * previous_loader_;
+};
+
 /**
  * @brief This function extracts a reference to the FactoryMap for appropriate base class out of the global plugin base to factory map. This function should be used by functions in this namespace that need to access the various factories so as to make sure the right key is generated to index into the global map.
  * @return A reference to the FactoryMap contained within the global Base-to-FactoryMap map.
@@ -130,6 +215,13 @@ void setCurrentlyActiveClassLoader(ClassLoader * loader);
 CLASS_LOADER_PUBLIC
 FactoryMap & getFactoryMapForBaseClass(const std::string & typeid_base_class_name);
 
+/**
+ * @brief Same as above but takes the interned ID of the base class name (@see internSymbol()). Must be invoked while holding getPluginBaseToFactoryMapMapMutex(), the FactoryMap must only be modified through insertMetaObjectIntoFactoryMap() as findFactory() reads it under the lock of its shard instead.
+ * @return A reference to the FactoryMap contained within the global Base-to-FactoryMap map.
+ */
+CLASS_LOADER_PUBLIC
+FactoryMap & getFactoryMapForBaseClass(SymbolId typeid_base_class_id);
+
 /**
  * @brief Same as above but uses a type parameter instead of string for more safety if info is available.
  * @return A reference to the FactoryMap contained within the global Base-to-FactoryMap map.
@@ -137,7 +229,7 @@ FactoryMap & getFactoryMapForBaseClass(const std::string & typeid_base_class_nam
 template<typename Base>
 FactoryMap & getFactoryMapForBaseClass()
 {
-  return getFactoryMapForBaseClass(typeid(Base).name());
+  return getFactoryMapForBaseClass(getBaseClassId<Base>());
 }
 
 /**
@@ -149,6 +241,45 @@ boost::recursive_mutex & getLoadedLibraryVectorMutex();
 CLASS_LOADER_PUBLIC
 boost::recursive_mutex & getPluginBaseToFactoryMapMapMutex();
 
+/**
+ * @brief Marks the whole global Base-to-FactoryMap map as modified so that the snapshots used by findFactory() are rebuilt on their next use. Modifications made through insertMetaObjectIntoFactoryMap() and library unloads only invalidate the snapshot of the shard of the base class concerned themselves.
+ */
+CLASS_LOADER_PUBLIC
+void invalidateFactoryIndex();
+
+/**
+ * @brief Rebuilds the snapshots of the global factory map map that findFactory() looks up factories in if they are out of date, so that the next lookups do not have to
+ */
+CLASS_LOADER_PUBLIC
+void prepareFactoryIndex();
+
+/**
+ * @brief Inserts a factory into a FactoryMap of the global Base-to-FactoryMap map under its class ID and indexes it under its associated library, replacing any factory previously registered under the same class name.
+ * @param factory_map - The FactoryMap of the factory's base class, @see getFactoryMapForBaseClass()
+ * @param meta_obj - The factory
+ */
+CLASS_LOADER_PUBLIC
+void insertMetaObjectIntoFactoryMap(FactoryMap & factory_map, AbstractMetaObjectBase * meta_obj);
+
+/**
+ * @brief Looks up the factory of a class without taking the global plugin map mutex. The global Base-to-FactoryMap map is sharded by base class, and lookups are answered from a read-only, hashed snapshot of the shard of the base class which each thread caches; only the mutex of the shard is taken to refresh that snapshot after a FactoryMap of the shard has changed (i.e. on library load/unload or plugin registration), so changes to the factories of other base classes never stall the lookup.
+ * @param typeid_base_class_name - The result of typeid(Base).name() for the base class
+ * @param class_name - The literal name of the derived class (unmangled)
+ * @return A pointer to the factory, nullptr if none is registered
+ */
+CLASS_LOADER_PUBLIC
+AbstractMetaObjectBase * findFactory(
+  const std::string & typeid_base_class_name, const std::string & class_name);
+
+/**
+ * @brief Same as above but takes the interned IDs of the names (@see internSymbol())
+ * @param typeid_base_class_id - The ID of typeid(Base).name() for the base class
+ * @param class_id - The ID of the literal name of the derived class
+ * @return A pointer to the factory, nullptr if none is registered
+ */
+CLASS_LOADER_PUBLIC
+AbstractMetaObjectBase * findFactory(SymbolId typeid_base_class_id, SymbolId class_id);
+
 /**
  * @brief Indicates if a library containing more than just plugins has been opened by the running process
  * @return True if a non-pure plugin library has been opened, otherwise false
@@ -163,6 +294,215 @@ bool hasANonPurePluginLibraryBeenOpened();
 CLASS_LOADER_PUBLIC
 void hasANonPurePluginLibraryBeenOpened(bool hasIt);
 
+// Diagnostics of the rare misuse cases, kept out of line so that the templates in this header do
+// not carry their long messages into every plugin library
+
+/**
+ * @brief Logs that a library containing plugins was opened by means other than a ClassLoader
+ */
+CLASS_LOADER_PUBLIC
+void logNonPurePluginLibraryAlert();
+
+/**
+ * @brief Logs that a plugin factory overwrites an existing one registered under the same name
+ * @param class_name - The name of the plugin class
+ */
+CLASS_LOADER_PUBLIC
+void logNamespaceCollisionWarning(const std::string & class_name);
+
+/**
+ * @brief Logs that a factory used for creating an object is not owned by any ClassLoader
+ */
+CLASS_LOADER_PUBLIC
+void logUnownedFactoryAlert();
+
+/**
+ * @brief Allocates the ID a ClassLoader is tracked by as an owner of metaobjects, which is the index of its bit in the owner bitmaps of the metaobjects. IDs are dense, the lowest free ID is handed out first and 0 stands for no ClassLoader.
+ * @return The ID
+ */
+CLASS_LOADER_PUBLIC
+size_t allocateClassLoaderId();
+
+/**
+ * @brief Returns an ID obtained with allocateClassLoaderId() so that it can be handed out again. The ClassLoader must not own any metaobject anymore.
+ * @param id - The ID
+ */
+CLASS_LOADER_PUBLIC
+void freeClassLoaderId(size_t id);
+
+/**
+ * @brief Has the unload reaper thread invoke a function once a point in time is reached, used by ClassLoader to unload its library when the grace period after the last plugin was destroyed elapsed. An unload scheduled before for the same ClassLoader is replaced.
+ * @param loader - The ClassLoader the unload is for
+ * @param deadline - When to invoke the function
+ * @param unload - The function, which must not throw anything but a ClassLoaderException
+ */
+CLASS_LOADER_PUBLIC
+void scheduleDeferredUnload(
+  const ClassLoader * loader, std::chrono::steady_clock::time_point deadline,
+  std::function<void()> unload);
+
+/**
+ * @brief Cancels the unload scheduled for a ClassLoader, @see scheduleDeferredUnload()
+ * @param loader - The ClassLoader the unload is for
+ * @param wait - Set to true to also wait for the unload to complete if it is running right now, which must not be done while holding any mutex of the ClassLoader
+ */
+CLASS_LOADER_PUBLIC
+void cancelDeferredUnload(const ClassLoader * loader, bool wait);
+
+/**
+ * @brief Invokes a task for every index from 0 to num_tasks - 1, spread across a number of threads including the calling one. All tasks run even if some throw, the exception of the task with the lowest index is then rethrown.
+ * @param num_tasks - The number of tasks
+ * @param num_threads - The maximum number of threads, 0 and 1 run the tasks in the calling thread
+ * @param task - The task, invoked with the index
+ */
+CLASS_LOADER_PUBLIC
+void runConcurrently(
+  size_t num_tasks, size_t num_threads, const std::function<void(size_t)> & task);
+
+// Statistics
+
+/**
+ * @brief Load statistics of a library, @see getStatistics()
+ */
+struct LibraryStatistics
+{
+  std::string library_path;
+  /// Number of times the library was opened and closed
+  size_t load_count;
+  size_t unload_count;
+  /// Total time spent opening the library, which includes running its static initializers
+  uint64_t dlopen_time_ns;
+  /// Total time spent registering the factories of the library, part of dlopen_time_ns
+  uint64_t registration_time_ns;
+  /// Number of factories revived from the graveyard on reloads, and of factories purged from it
+  /// as the reloaded library registered new ones
+  size_t graveyard_revival_count;
+  size_t graveyard_purge_count;
+};
+
+/**
+ * @brief Creation statistics of a class, @see getStatistics()
+ */
+struct ClassStatistics
+{
+  std::string class_name;
+  std::string base_class_name;
+  std::string library_path;
+  /// Number of instances created, by any means
+  size_t creation_count;
+  /// Number of instances destroyed, which only counts instances managed by a ClassLoader
+  size_t destruction_count;
+};
+
+/**
+ * @brief Statistics of the plugin system, @see getStatistics()
+ */
+struct Statistics
+{
+  std::vector<LibraryStatistics> libraries;
+  std::vector<ClassStatistics> classes;
+};
+
+/**
+ * @brief Gets the statistics collected since the start of the process (or the last call to resetStatistics()), for every library that was loaded and every class with a factory, also of unloaded libraries. Collecting is done with relaxed atomic counters on the creation paths and is compiled out if CLASS_LOADER_DISABLE_STATISTICS is defined, in which case everything is reported as 0.
+ * @return The statistics
+ */
+CLASS_LOADER_PUBLIC
+Statistics getStatistics();
+
+/**
+ * @brief Sets all statistics back to 0, @see getStatistics()
+ */
+CLASS_LOADER_PUBLIC
+void resetStatistics();
+
+/**
+ * @class ScopedRegistrationTimer
+ * @brief Adds the time from its construction to its destruction to the registration time of the library the calling thread is loading, @see LibraryStatistics
+ */
+class CLASS_LOADER_PUBLIC ScopedRegistrationTimer
+{
+public:
+  ScopedRegistrationTimer();
+  ~ScopedRegistrationTimer();
+
+private:
+  ScopedRegistrationTimer(const ScopedRegistrationTimer &);
+  ScopedRegistrationTimer & operator=(const ScopedRegistrationTimer &);
+
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @class ScopedStagedRegistration
+ * @brief While alive, the factories of the libraries the calling thread loads are staged: they are indexed under their library but not put into the factory maps until publishLibraryFactories() is called, so that a new build of a loaded library does not replace the factories of the old one while it is still being opened.
+ */
+class CLASS_LOADER_PUBLIC ScopedStagedRegistration
+{
+public:
+  ScopedStagedRegistration();
+  ~ScopedStagedRegistration();
+
+private:
+  ScopedStagedRegistration(const ScopedStagedRegistration &);
+  ScopedStagedRegistration & operator=(const ScopedStagedRegistration &);
+
+  bool previous_staging_;
+};
+
+/**
+ * @brief Indicates if the factories registered by the calling thread are staged, @see ScopedStagedRegistration
+ */
+CLASS_LOADER_PUBLIC
+bool isStagingRegistrations();
+
+// Memory
+
+/**
+ * @brief Memory used by the plugin system, @see getMemoryUsage(). The sizes of the standard containers are estimated from their element counts, as they do not report their allocations themselves.
+ */
+struct MemoryUsage
+{
+  /// Factories currently registered, and the bytes of their arena slots and owner lists
+  size_t meta_object_count;
+  size_t meta_object_bytes;
+  /// Factories kept in the graveyard after their libraries were unloaded, and their bytes
+  size_t graveyard_meta_object_count;
+  size_t graveyard_bytes;
+  /// Bytes the metaobject arena reserved, including the free slots it keeps for reuse
+  size_t arena_bytes;
+  /// Bytes of the factory maps, their lookup snapshots and the index of factories by library
+  size_t registry_bytes;
+  /// Interned names, which the factories share rather than keeping copies (@see internSymbol())
+  size_t symbol_count;
+  size_t symbol_bytes;
+  /// Libraries currently open, and the bytes of their mapped segments (Linux only, 0 elsewhere)
+  size_t loaded_library_count;
+  size_t mapped_library_bytes;
+};
+
+/**
+ * @brief Gets the memory the plugin system uses for the factories of the registered classes, the graveyard, the loaded libraries and the structures indexing them.
+ * @return The memory usage
+ */
+CLASS_LOADER_PUBLIC
+MemoryUsage getMemoryUsage();
+
+/**
+ * @brief Allocates the storage of a metaobject from the metaobject arena, which carves equally sized slots out of slabs so that thousands of small factories neither carry a heap header each nor fragment the heap. Slots are reused once freed, slabs are kept. Throws std::bad_alloc on failure.
+ * @param size - The size of the metaobject
+ * @return The storage, aligned for any type
+ */
+CLASS_LOADER_PUBLIC
+void * allocateMetaObjectStorage(size_t size);
+
+/**
+ * @brief Frees the storage of a metaobject allocated by allocateMetaObjectStorage()
+ * @param storage - The storage, may be nullptr
+ */
+CLASS_LOADER_PUBLIC
+void freeMetaObjectStorage(void * storage);
+
 // Plugin Functions
 
 /**
@@ -170,123 +510,154 @@ void hasANonPurePluginLibraryBeenOpened(bool hasIt);
  * Classes that use that macro will cause this function to be invoked when the library is loaded. The function will create a MetaObject (i.e. factory) for the corresponding Derived class and insert it into the appropriate FactoryMap in the global Base-to-FactoryMap map. Note that the passed class_name is the literal class name and not the mangled version.
  * @param Derived - parameteric type indicating concrete type of plugin
  * @param Base - parameteric type indicating base type of plugin
+ * @param Args - the types of the constructor arguments, if the class is constructed from arguments (@see CLASS_LOADER_REGISTER_CLASS_WITH_ARGS)
  * @param class_name - the literal name of the class being registered (NOT MANGLED)
  */
-template<typename Derived, typename Base>
+template<typename Derived, typename Base, typename ... Args>
 void registerPlugin(const std::string & class_name, const std::string & base_class_name)
 {
   // Note: This function will be automatically invoked when a dlopen() call
   // opens a library. Normally it will happen within the scope of loadLibrary(),
   // but that may not be guaranteed.
-  CONSOLE_BRIDGE_logDebug(
+#ifndef CLASS_LOADER_DISABLE_STATISTICS
+  ScopedRegistrationTimer registration_timer;
+#endif
+  ScopedTrace trace(TRACE_REGISTRATION, class_name);
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.impl: "
     "Registering plugin factory for class = %s, ClassLoader* = %p and library name %s.",
     class_name.c_str(), getCurrentlyActiveClassLoader(),
     getCurrentlyLoadingLibraryName().c_str());
 
   if (nullptr == getCurrentlyActiveClassLoader()) {
-    CONSOLE_BRIDGE_logDebug("%s",
-      "class_loader.impl: ALERT!!! "
-      "A library containing plugins has been opened through a means other than through the "
-      "class_loader or pluginlib package. "
-      "This can happen if you build plugin libraries that contain more than just plugins "
-      "(i.e. normal code your app links against). "
-      "This inherently will trigger a dlopen() prior to main() and cause problems as class_loader "
-      "is not aware of plugin factories that autoregister under the hood. "
-      "The class_loader package can compensate, but you may run into namespace collision problems "
-      "(e.g. if you have the same plugin class in two different libraries and you load them both "
-      "at the same time). "
-      "The biggest problem is that library can now no longer be safely unloaded as the "
-      "ClassLoader does not know when non-plugin code is still in use. "
-      "In fact, no ClassLoader instance in your application will be unable to unload any library "
-      "once a non-pure one has been opened. "
-      "Please refactor your code to isolate plugins into their own libraries.");
+    logNonPurePluginLibraryAlert();
     hasANonPurePluginLibraryBeenOpened(true);
   }
 
   // Create factory
-  impl::AbstractMetaObject<Base> * new_factory =
-    new impl::MetaObject<Derived, Base>(class_name, base_class_name);
+  impl::AbstractMetaObject<Base, Args...> * new_factory =
+    new impl::MetaObject<Derived, Base, Args...>(class_name, base_class_name);
   new_factory->addOwningClassLoader(getCurrentlyActiveClassLoader());
   new_factory->setAssociatedLibraryPath(getCurrentlyLoadingLibraryName());
 
 
   // Add it to global factory map map
   getPluginBaseToFactoryMapMapMutex().lock();
-  FactoryMap & factoryMap = getFactoryMapForBaseClass<Base>();
-  if (factoryMap.find(class_name) != factoryMap.end()) {
-    CONSOLE_BRIDGE_logWarn(
-      "class_loader.impl: SEVERE WARNING!!! "
-      "A namespace collision has occured with plugin factory for class %s. "
-      "New factory will OVERWRITE existing one. "
-      "This situation occurs when libraries containing plugins are directly linked against an "
-      "executable (the one running right now generating this message). "
-      "Please separate plugins out into their own library or just don't link against the library "
-      "and use either class_loader::ClassLoader/MultiLibraryClassLoader to open.",
-      class_name.c_str());
+  FactoryMap & factoryMap =
+    getFactoryMapForBaseClass<typename FactoryBaseType<Base, Args...>::type>();
+  if (!isStagingRegistrations() && factoryMap.find(new_factory->classId()) != factoryMap.end()) {
+    logNamespaceCollisionWarning(class_name);
   }
-  factoryMap[class_name] = new_factory;
+  insertMetaObjectIntoFactoryMap(factoryMap, new_factory);
   getPluginBaseToFactoryMapMapMutex().unlock();
 
-  CONSOLE_BRIDGE_logDebug(
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.impl: "
     "Registration of %s complete (Metaobject Address = %p)",
     class_name.c_str(), reinterpret_cast<void *>(new_factory));
 }
 
 /**
- * @brief This function creates an instance of a plugin class given the derived name of the class and returns a pointer of the Base class type.
- * @param derived_class_name - The name of the derived class (unmangled)
+ * @brief This function looks up the factory of a plugin class given the interned ID of the derived name of the class, making sure it is within the scope of the passed ClassLoader.
+ * @param derived_class_id - The ID of the name of the derived class (@see internSymbol())
  * @param loader - The ClassLoader whose scope we are within
- * @return A pointer to newly created plugin, note caller is responsible for object destruction
+ * @return A pointer to the factory for the class, never nullptr as an exception is thrown on failure
  */
-template<typename Base>
-Base * createInstance(const std::string & derived_class_name, ClassLoader * loader)
+template<typename Base, typename ... Args>
+AbstractMetaObject<Base, Args...> *
+getFactoryForClass(SymbolId derived_class_id, ClassLoader * loader)
 {
-  AbstractMetaObject<Base> * factory = nullptr;
+  AbstractMetaObject<Base, Args...> * factory =
+    dynamic_cast<impl::AbstractMetaObject<Base, Args...> *>(findFactory(
+      getBaseClassId<typename FactoryBaseType<Base, Args...>::type>(), derived_class_id));
+  if (nullptr == factory) {
+    CLASS_LOADER_LOG_ERROR(
+      "class_loader.impl: No metaobject exists for class type %s.",
+      getSymbolName(derived_class_id).c_str());
+  } else if (factory->isOwnedBy(loader)) {
+    return factory;
+  } else if (factory->isOwnedBy(nullptr)) {
+    logUnownedFactoryAlert();
+    return factory;
+  }
 
-  getPluginBaseToFactoryMapMapMutex().lock();
-  FactoryMap & factoryMap = getFactoryMapForBaseClass<Base>();
-  if (factoryMap.find(derived_class_name) != factoryMap.end()) {
-    factory = dynamic_cast<impl::AbstractMetaObject<Base> *>(factoryMap[derived_class_name]);
-  } else {
-    CONSOLE_BRIDGE_logError(
+  throw class_loader::CreateClassException(
+          "Could not create instance of type " + getSymbolName(derived_class_id));
+}
+
+/**
+ * @brief This function looks up the factory of a plugin class given the derived name of the class, making sure it is within the scope of the passed ClassLoader.
+ * @param derived_class_name - The name of the derived class (unmangled)
+ * @param loader - The ClassLoader whose scope we are within
+ * @return A pointer to the factory for the class, never nullptr as an exception is thrown on failure
+ */
+template<typename Base, typename ... Args>
+AbstractMetaObject<Base, Args...> * getFactoryForClass(
+  const std::string & derived_class_name, ClassLoader * loader)
+{
+  SymbolId derived_class_id = findSymbol(derived_class_name);
+  if (kInvalidSymbolId == derived_class_id) {
+    // No factory was ever registered under that name
+    CLASS_LOADER_LOG_ERROR(
       "class_loader.impl: No metaobject exists for class type %s.", derived_class_name.c_str());
+    throw class_loader::CreateClassException(
+            "Could not create instance of type " + derived_class_name);
   }
-  getPluginBaseToFactoryMapMapMutex().unlock();
+  return getFactoryForClass<Base, Args...>(derived_class_id, loader);
+}
 
-  Base * obj = nullptr;
-  if (factory != nullptr && factory->isOwnedBy(loader)) {
-    obj = factory->create();
-  }
+/**
+ * @brief Passes a constructor argument on to a factory, which takes it as an rvalue reference of its decayed type (@see AbstractMetaObject): an rvalue of that type is passed as is, so that it is moved into the constructor.
+ * @param Arg - The type the argument was forwarded as, i.e. Args of an Args && parameter
+ */
+template<typename Arg>
+typename std::enable_if<
+  std::is_same<Arg, typename std::decay<Arg>::type>::value, Arg &&>::type
+forwardConstructorArgument(Arg & arg)
+{
+  return std::move(arg);
+}
 
-  if (nullptr == obj) {  // Was never created
-    if (factory && factory->isOwnedBy(nullptr)) {
-      CONSOLE_BRIDGE_logDebug("%s",
-        "class_loader.impl: ALERT!!! "
-        "A metaobject (i.e. factory) exists for desired class, but has no owner. "
-        "This implies that the library containing the class was dlopen()ed by means other than "
-        "through the class_loader interface. "
-        "This can happen if you build plugin libraries that contain more than just plugins "
-        "(i.e. normal code your app links against) -- that intrinsically will trigger a dlopen() "
-        "prior to main(). "
-        "You should isolate your plugins into their own library, otherwise it will not be "
-        "possible to shutdown the library!");
-
-      obj = factory->create();
-    } else {
-      throw class_loader::CreateClassException(
-              "Could not create instance of type " + derived_class_name);
-    }
-  }
+/**
+ * @brief Same as above for lvalues and arguments of other types, which are converted to a temporary of the decayed type, i.e. copied.
+ */
+template<typename Arg>
+typename std::enable_if<
+  !std::is_same<Arg, typename std::decay<Arg>::type>::value, typename std::decay<Arg>::type>::type
+forwardConstructorArgument(typename std::remove_reference<Arg>::type & arg)
+{
+  return arg;
+}
+
+/**
+ * @brief This function creates an instance of a plugin class given the derived name of the class (or its interned ID) and returns a pointer of the Base class type.
+ * @param derived_class - The name of the derived class (unmangled) or its ID
+ * @param loader - The ClassLoader whose scope we are within
+ * @return A pointer to newly created plugin, note caller is responsible for object destruction
+ */
+template<typename Base, typename ClassKey>
+Base * createInstance(const ClassKey & derived_class, ClassLoader * loader)
+{
+  Base * obj = getFactoryForClass<Base>(derived_class, loader)->create();
 
-  CONSOLE_BRIDGE_logDebug(
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.impl: Created instance of type %s and object pointer = %p",
     (typeid(obj).name()), reinterpret_cast<void *>(obj));
 
   return obj;
 }
 
+/**
+ * @brief Invokes a callback with every factory of a class derived from a base class that is within scope of the passed ClassLoader, i.e. that it owns or that is not associated with any ClassLoader. Only the factories of the libraries the ClassLoader owns factories of are visited rather than the whole factory map. Owned factories are visited first, each library in registration order. The global plugin map mutex is held while visiting, so the callback must not wait for other threads using the plugin system.
+ * @param loader - The ClassLoader whose scope we are within
+ * @param typeid_base_class_id - The interned ID of typeid(Base).name() for the base class
+ * @param callback - Invoked with each factory
+ */
+CLASS_LOADER_PUBLIC
+void forEachAvailableFactory(
+  const ClassLoader * loader, SymbolId typeid_base_class_id,
+  const std::function<void(AbstractMetaObjectBase *)> & callback);
+
 /**
  * @brief This function returns all the available class_loader in the plugin system that are derived from Base and within scope of the passed ClassLoader.
  * @param loader - The pointer to the ClassLoader whose scope we are within,
@@ -295,20 +666,22 @@ Base * createInstance(const std::string & derived_class_name, ClassLoader * load
 template<typename Base>
 std::vector<std::string> getAvailableClasses(ClassLoader * loader)
 {
-  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
-
-  FactoryMap & factory_map = getFactoryMapForBaseClass<Base>();
   std::vector<std::string> classes;
   std::vector<std::string> classes_with_no_owner;
 
-  for (auto & it : factory_map) {
-    AbstractMetaObjectBase * factory = it.second;
-    if (factory->isOwnedBy(loader)) {
-      classes.push_back(it.first);
-    } else if (factory->isOwnedBy(nullptr)) {
-      classes_with_no_owner.push_back(it.first);
-    }
-  }
+  forEachAvailableFactory(
+    loader, getBaseClassId<Base>(),
+    [loader, &classes, &classes_with_no_owner](AbstractMetaObjectBase * factory) {
+      if (factory->isOwnedBy(loader)) {
+        classes.push_back(factory->className());
+      } else {
+        classes_with_no_owner.push_back(factory->className());
+      }
+    });
+
+  // Note: Factories are visited in registration order, keep listing classes in alphabetical order
+  std::sort(classes.begin(), classes.end());
+  std::sort(classes_with_no_owner.begin(), classes_with_no_owner.end());
 
   // Added classes not associated with a class loader (Which can happen through
   // an unexpected dlopen() to the library)
@@ -316,6 +689,36 @@ std::vector<std::string> getAvailableClasses(ClassLoader * loader)
   return classes;
 }
 
+/**
+ * @brief This function invokes a callback with the name of every class in the plugin system that is derived from Base and within scope of the passed ClassLoader, without copying any name, @see forEachAvailableFactory()
+ * @param loader - The pointer to the ClassLoader whose scope we are within
+ * @param callback - Invoked as callback(const std::string & class_name), the name is only valid during the call
+ */
+template<typename Base, typename Callback>
+void forEachAvailableClass(ClassLoader * loader, Callback && callback)
+{
+  forEachAvailableFactory(
+    loader, getBaseClassId<Base>(),
+    [&callback](AbstractMetaObjectBase * factory) {callback(factory->className());});
+}
+
+/**
+ * @brief This function indicates if a class derived from Base is available within scope of the passed ClassLoader, looking up its factory rather than listing all classes.
+ * @param class_name - The name of the derived class (unmangled)
+ * @param loader - The pointer to the ClassLoader whose scope we are within
+ * @return true if the class is available, false otherwise
+ */
+template<typename Base>
+bool isClassAvailable(const std::string & class_name, ClassLoader * loader)
+{
+  SymbolId class_id = findSymbol(class_name);
+  if (kInvalidSymbolId == class_id) {
+    return false;
+  }
+  AbstractMetaObjectBase * factory = findFactory(getBaseClassId<Base>(), class_id);
+  return nullptr != factory && (factory->isOwnedBy(loader) || factory->isOwnedBy(nullptr));
+}
+
 /**
  * @brief This function returns the names of all libraries in use by a given class loader.
  * @param loader - The ClassLoader whose scope we are within
@@ -324,6 +727,117 @@ std::vector<std::string> getAvailableClasses(ClassLoader * loader)
 CLASS_LOADER_PUBLIC
 std::vector<std::string> getAllLibrariesUsedByClassLoader(const ClassLoader * loader);
 
+/**
+ * @brief This function returns the classes a library registered factories for that are within scope of the passed ClassLoader, along with the base class each of them derives from.
+ * @param library_path - The name of the library
+ * @param loader - The ClassLoader whose scope we are within
+ * @return A vector of (typeid(Base).name(), class name) pairs of interned IDs
+ */
+CLASS_LOADER_PUBLIC
+std::vector<std::pair<SymbolId, SymbolId>>
+getRegisteredClassesForLibrary(const std::string & library_path, const ClassLoader * loader);
+
+/**
+ * @brief Gets the path of the manifest generated for a library by the class_loader_generate_manifest() CMake function. If the library path is a bare file name, the directories in LD_LIBRARY_PATH are searched for it first.
+ * @param library_path - The name of the library
+ * @return The path to the manifest, an empty string if there is none
+ */
+CLASS_LOADER_PUBLIC
+std::string findLibraryManifest(const std::string & library_path);
+
+/**
+ * @brief Sets the directory of the plugin catalog, a cache of the classes libraries provide which all processes using the same directory share. Every library loaded is recorded in a memory-mapped entry file keyed by the path, modification time, size and inode of the library file, and libraries without a manifest of their own then get one from their catalog entry, as long as the file did not change. An empty directory, the default unless the CLASS_LOADER_CATALOG_DIR environment variable is set, disables the catalog. Not supported on Windows.
+ * @param directory - The directory, which is created if it does not exist but its parent does
+ */
+CLASS_LOADER_PUBLIC
+void setPluginCatalogDirectory(const std::string & directory);
+
+/**
+ * @brief Gets the directory of the plugin catalog, @see setPluginCatalogDirectory()
+ */
+CLASS_LOADER_PUBLIC
+std::string getPluginCatalogDirectory();
+
+/**
+ * @brief Records the classes of a loaded library in the plugin catalog, unless the catalog is disabled or already has an up to date entry for the library, @see setPluginCatalogDirectory()
+ * @param library_path - The name of the library
+ */
+CLASS_LOADER_PUBLIC
+void recordLibraryInCatalog(const std::string & library_path);
+
+/**
+ * @brief Indicates if a library has a manifest listing the classes it provides, either generated (@see findLibraryManifest()) or from the plugin catalog (@see setPluginCatalogDirectory())
+ * @param library_path - The name of the library
+ * @return true if a manifest exists, false otherwise
+ */
+CLASS_LOADER_PUBLIC
+bool hasLibraryManifest(const std::string & library_path);
+
+/**
+ * @brief Gets the classes derived from a base class which the manifest of a library lists, without opening the library. Manifests are parsed once and cached. As manifests record base classes as they are spelled in the registration macro, the base class matches if that spelling names the demangled typeid name, possibly relative to an enclosing namespace.
+ * @param library_path - The name of the library
+ * @param typeid_base_class_name - The result of typeid(Base).name() for the base class
+ * @param classes - Receives the names of the classes
+ * @return true if the library has a manifest, false otherwise
+ */
+CLASS_LOADER_PUBLIC
+bool getManifestClassesForLibrary(
+  const std::string & library_path, const std::string & typeid_base_class_name,
+  std::vector<std::string> & classes);
+
+/**
+ * @brief Same as getManifestClassesForLibrary() but invokes a callback with the name of each class instead of copying the names
+ * @param library_path - The name of the library
+ * @param typeid_base_class_name - The result of typeid(Base).name() for the base class
+ * @param callback - Invoked with the name of each class
+ * @return true if the library has a manifest, false otherwise
+ */
+CLASS_LOADER_PUBLIC
+bool forEachManifestClassForLibrary(
+  const std::string & library_path, const std::string & typeid_base_class_name,
+  const std::function<void(const std::string &)> & callback);
+
+/**
+ * @brief Gets the libraries a library links against, i.e. the DT_NEEDED entries of its dynamic section, without opening it. The library file is searched for the way findLibraryManifest() does. Only ELF libraries of the native word size are supported, for others an empty vector is returned.
+ * @param library_path - The name of the library
+ * @return The file names of the needed libraries, as recorded by the linker (e.g. "libfoo.so.1")
+ */
+CLASS_LOADER_PUBLIC
+std::vector<std::string> getNeededLibraries(const std::string & library_path);
+
+/**
+ * @brief Gets the symbols a library exports (i.e. the defined functions and objects of default visibility in its dynamic symbol table) that the process already resolves to another, loaded library, e.g. to an earlier build of the same library. Once opened with global lookup, the library binds its references to these symbols to the loaded library instead of its own definitions. The library file is read without opening it, the way getNeededLibraries() does. Only ELF libraries on Linux are supported, for others an empty vector is returned.
+ * @param library_path - The name of the library
+ * @param loaded_library_path - The path the loaded library was opened with
+ * @return The demangled names of the symbols
+ */
+CLASS_LOADER_PUBLIC
+std::vector<std::string> getSymbolsInterposedByLibrary(
+  const std::string & library_path, const std::string & loaded_library_path);
+
+/**
+ * @brief Copies the file of a library to a new file in the temporary directory (TMPDIR, /tmp by default), so that the copy can be opened while the library is loaded, which it cannot be under its own path as the runtime loader hands out the loaded library again. Only supported on POSIX systems.
+ * @param library_path - The name of the library, searched for the way findLibraryManifest() does
+ * @return The path of the copy
+ * @throws LibraryLoadException if the library cannot be copied
+ */
+CLASS_LOADER_PUBLIC
+std::string createLibrarySnapshot(const std::string & library_path);
+
+/**
+ * @brief Removes a copy made by createLibrarySnapshot() along with the factories of it left in the graveyard, unless it is still loaded
+ * @param snapshot_path - The path of the copy
+ */
+CLASS_LOADER_PUBLIC
+void discardLibrarySnapshot(const std::string & snapshot_path);
+
+/**
+ * @brief Puts the staged factories of a library into the factory maps at once, in place of the factories of the same classes from other libraries (@see ScopedStagedRegistration). The replaced factories stay with their libraries, which still own them until they are unloaded.
+ * @param library_path - The name of the library
+ */
+CLASS_LOADER_PUBLIC
+void publishLibraryFactories(const std::string & library_path);
+
 /**
  * @brief Indicates if passed library loaded within scope of a ClassLoader. The library maybe loaded in memory, but to the class loader it may not be.
  * @param library_path - The name of the library we wish to check is open
@@ -341,6 +855,14 @@ bool isLibraryLoaded(const std::string & library_path, ClassLoader * loader);
 CLASS_LOADER_PUBLIC
 bool isLibraryLoadedByAnybody(const std::string & library_path);
 
+/**
+ * @brief Faults in the pages of a library loaded in memory, by advising the kernel to read it ahead and then touching every readable page, so that first calls into the library do not page fault. Only supported on Linux, elsewhere this does nothing.
+ * @param library_path - The name of the library, as it was loaded
+ * @return The number of pages touched, 0 if the library is not loaded
+ */
+CLASS_LOADER_PUBLIC
+size_t prefaultLibrary(const std::string & library_path);
+
 /**
  * @brief Loads a library into memory if it has not already been done so. Attempting to load an already loaded library has no effect.
  * @param library_path - The name of the library to open
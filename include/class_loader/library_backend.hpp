@@ -0,0 +1,124 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CLASS_LOADER__LIBRARY_BACKEND_HPP_
+#define CLASS_LOADER__LIBRARY_BACKEND_HPP_
+
+#include <string>
+
+#include "class_loader/visibility_control.hpp"
+
+namespace class_loader
+{
+
+/**
+ * @brief Flags controlling how the runtime loader opens a library, @see ClassLoader::ClassLoader().
+ * They are hints, the native backend maps them to dlopen() flags and ignores them on Windows.
+ */
+enum LibraryLoadFlags
+{
+  /// Symbols are bound when first used (RTLD_LAZY) and are made available to libraries opened
+  /// later (RTLD_GLOBAL)
+  LIBRARY_LOAD_DEFAULT = 0,
+  /// Binds all symbols when the library is opened (RTLD_NOW), so that missing symbols fail the
+  /// load rather than a later call
+  LIBRARY_LOAD_NOW = 1 << 0,
+  /// Does not make the symbols of the library available to libraries opened later (RTLD_LOCAL).
+  /// Only use this if no other library relies on its typeinfo or other symbols, as dynamic_cast
+  /// and exceptions across libraries may fail otherwise.
+  LIBRARY_LOAD_LOCAL = 1 << 1,
+  /// Keeps the library mapped when it is closed (RTLD_NODELETE), for libraries that would be
+  /// reopened anyway. Its factories are then revived from the graveyard on reload.
+  LIBRARY_LOAD_NODELETE = 1 << 2,
+  /// Binds the references of the library to its own symbols and those of its dependencies ahead
+  /// of those of the libraries opened before it (RTLD_DEEPBIND, glibc only). Use with care: the
+  /// library then also binds to the copies of its dependencies' data that the executable has
+  /// relocated into itself (copy relocations), e.g. std::cout of libstdc++ in an executable using
+  /// std::cout, which are never constructed, so that a library writing to std::cout crashes.
+  /// The sanitizer runtimes refuse to open such libraries.
+  LIBRARY_LOAD_DEEPBIND = 1 << 3
+};
+
+namespace impl
+{
+
+/**
+ * @brief An opaque handle of a library opened by a LibraryBackend
+ */
+typedef void * LibraryHandle;
+
+/**
+ * @class LibraryBackend
+ * @brief Opens and closes the runtime libraries of the plugin system. The backend in use is replaced by setLibraryBackend(), e.g. to wrap the runtime loader of a platform without dlopen().
+ */
+class CLASS_LOADER_PUBLIC LibraryBackend
+{
+public:
+  virtual ~LibraryBackend();
+
+  /**
+   * @brief Opens a library, throws class_loader::LibraryLoadException on failure
+   * @param library_path - The path of the library to open
+   * @param flags - A combination of LibraryLoadFlags
+   * @return The handle of the library, never nullptr
+   */
+  virtual LibraryHandle open(const std::string & library_path, int flags) = 0;
+
+  /**
+   * @brief Closes a library opened by open(), throws class_loader::LibraryUnloadException on failure
+   * @param handle - The handle of the library
+   */
+  virtual void close(LibraryHandle handle) = 0;
+};
+
+/**
+ * @brief Gets the backend opening libraries with the native runtime loader, i.e. dlopen() or LoadLibrary()
+ */
+CLASS_LOADER_PUBLIC
+LibraryBackend & getNativeLibraryBackend();
+
+/**
+ * @brief Gets the backend libraries are opened with, by default the native one unless class_loader was built with CLASS_LOADER_USE_POCO
+ */
+CLASS_LOADER_PUBLIC
+LibraryBackend & getLibraryBackend();
+
+/**
+ * @brief Sets the backend libraries are opened with from now on. Libraries already open are closed by the backend that opened them, so the backend must stay alive until they are.
+ * @param backend - The backend
+ */
+CLASS_LOADER_PUBLIC
+void setLibraryBackend(LibraryBackend & backend);
+
+}  // namespace impl
+}  // namespace class_loader
+
+#endif  // CLASS_LOADER__LIBRARY_BACKEND_HPP_
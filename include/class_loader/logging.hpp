@@ -0,0 +1,83 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CLASS_LOADER__LOGGING_HPP_
+#define CLASS_LOADER__LOGGING_HPP_
+
+#include <console_bridge/console.h>
+
+/**
+ * class_loader logs through console_bridge, but only messages at or above CLASS_LOADER_LOG_LEVEL
+ * are compiled in. Messages below it cost nothing at all: neither their arguments are evaluated
+ * nor is console_bridge called. The level can be set with the CLASS_LOADER_LOG_LEVEL CMake option
+ * and defaults to CLASS_LOADER_LOG_LEVEL_DEBUG, i.e. every message is left for console_bridge to
+ * filter at runtime.
+ */
+
+#define CLASS_LOADER_LOG_LEVEL_DEBUG 0
+#define CLASS_LOADER_LOG_LEVEL_INFO 1
+#define CLASS_LOADER_LOG_LEVEL_WARN 2
+#define CLASS_LOADER_LOG_LEVEL_ERROR 3
+#define CLASS_LOADER_LOG_LEVEL_NONE 4
+
+#ifndef CLASS_LOADER_LOG_LEVEL
+#define CLASS_LOADER_LOG_LEVEL CLASS_LOADER_LOG_LEVEL_DEBUG
+#endif
+
+// Note: The arguments only end up in an unevaluated operand, which keeps variables that are merely
+// logged from being reported as unused.
+#define CLASS_LOADER_LOG_DISABLED(...) do {(void)sizeof((__VA_ARGS__, 0));} while (false)
+
+#if CLASS_LOADER_LOG_LEVEL <= CLASS_LOADER_LOG_LEVEL_DEBUG
+#define CLASS_LOADER_LOG_DEBUG(...) CONSOLE_BRIDGE_logDebug(__VA_ARGS__)
+#else
+#define CLASS_LOADER_LOG_DEBUG(...) CLASS_LOADER_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if CLASS_LOADER_LOG_LEVEL <= CLASS_LOADER_LOG_LEVEL_INFO
+#define CLASS_LOADER_LOG_INFORM(...) CONSOLE_BRIDGE_logInform(__VA_ARGS__)
+#else
+#define CLASS_LOADER_LOG_INFORM(...) CLASS_LOADER_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if CLASS_LOADER_LOG_LEVEL <= CLASS_LOADER_LOG_LEVEL_WARN
+#define CLASS_LOADER_LOG_WARN(...) CONSOLE_BRIDGE_logWarn(__VA_ARGS__)
+#else
+#define CLASS_LOADER_LOG_WARN(...) CLASS_LOADER_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if CLASS_LOADER_LOG_LEVEL <= CLASS_LOADER_LOG_LEVEL_ERROR
+#define CLASS_LOADER_LOG_ERROR(...) CONSOLE_BRIDGE_logError(__VA_ARGS__)
+#else
+#define CLASS_LOADER_LOG_ERROR(...) CLASS_LOADER_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#endif  // CLASS_LOADER__LOGGING_HPP_
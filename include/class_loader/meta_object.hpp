@@ -35,11 +35,20 @@
 #ifndef CLASS_LOADER__META_OBJECT_HPP_
 #define CLASS_LOADER__META_OBJECT_HPP_
 
-#include <console_bridge/console.h>
+#include "class_loader/logging.hpp"
+#include "class_loader/tracer.hpp"
 #include "class_loader/visibility_control.hpp"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
 #include <typeinfo>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace class_loader
@@ -52,6 +61,11 @@ namespace impl
 
 typedef std::vector<class_loader::ClassLoader *> ClassLoaderVector;
 
+/**
+ * @brief Compact identifier of an interned class, base class or library name (@see internSymbol()), IDs are never reused during the lifetime of the process.
+ */
+typedef uint32_t SymbolId;
+
 /**
  * @class AbstractMetaObjectBase
  * @brief A base class for MetaObjects that excludes a polymorphic type parameter. Subclasses are class templates though.
@@ -74,22 +88,37 @@ public:
    * @brief Gets the literal name of the class.
    * @return The literal name of the class as a C-string.
    */
-  std::string className() const;
+  const std::string & className() const;
+
+  /**
+   * @brief Gets the interned ID of the literal name of the class
+   */
+  SymbolId classId() const;
 
   /**
    * @brief gets the base class for the class this factory represents
    */
-  std::string baseClassName() const;
+  const std::string & baseClassName() const;
   /**
    * @brief Gets the name of the class as typeid(BASE_CLASS).name() would return it
    */
-  std::string typeidBaseClassName() const;
+  const std::string & typeidBaseClassName() const;
+
+  /**
+   * @brief Gets the interned ID of typeidBaseClassName()
+   */
+  SymbolId typeidBaseClassId() const;
 
   /**
    * @brief Gets the path to the library associated with this factory
    * @return Library path as a std::string
    */
-  std::string getAssociatedLibraryPath();
+  const std::string & getAssociatedLibraryPath() const;
+
+  /**
+   * @brief Gets the interned ID of the path to the library associated with this factory
+   */
+  SymbolId associatedLibraryId() const;
 
   /**
    * @brief Sets the path to the library associated with this factory
@@ -109,7 +138,9 @@ public:
   void removeOwningClassLoader(const ClassLoader * loader);
 
   /**
-   * @brief Indicates if the factory is within the usable scope of a ClassLoader
+   * @brief Indicates if the factory is within the usable scope of a ClassLoader. This is a bit
+   * test which, for the first 64 ClassLoaders alive at a time, is safe to do without the global
+   * plugin map mutex.
    * @param loader Handle to the owning ClassLoader.
    */
   bool isOwnedBy(const ClassLoader * loader);
@@ -124,27 +155,168 @@ public:
    */
   ClassLoaderVector getAssociatedClassLoaders();
 
+  /**
+   * @brief Counts an instance created by this factory, a no-op if CLASS_LOADER_DISABLE_STATISTICS is defined
+   */
+  void countCreation() const
+  {
+#ifndef CLASS_LOADER_DISABLE_STATISTICS
+    creation_count_.fetch_add(1, std::memory_order_relaxed);
+#endif
+  }
+
+  /**
+   * @brief Counts the destruction of a managed instance created by this factory, a no-op if CLASS_LOADER_DISABLE_STATISTICS is defined
+   */
+  void countDestruction() const
+  {
+#ifndef CLASS_LOADER_DISABLE_STATISTICS
+    destruction_count_.fetch_add(1, std::memory_order_relaxed);
+#endif
+  }
+
+  /**
+   * @brief Gets the number of instances created by this factory, @see countCreation()
+   */
+  size_t getCreationCount() const;
+
+  /**
+   * @brief Gets the number of managed instances created by this factory that were destroyed, @see countDestruction()
+   */
+  size_t getDestructionCount() const;
+
+  /**
+   * @brief Sets the creation and destruction counts back to 0
+   */
+  void resetCounts();
+
+  /**
+   * @brief Gets the number of bytes the factory allocated on the heap in addition to its own storage, i.e. for its list and bitmap of owners, @see getMemoryUsage()
+   */
+  size_t getDynamicMemoryUsage() const;
+
+  /**
+   * @brief Allocates metaobjects from the metaobject arena rather than the general heap, @see allocateMetaObjectStorage()
+   */
+  static void * operator new(size_t size);
+
+  /**
+   * @brief Frees the storage of a metaobject allocated by operator new(), @see freeMetaObjectStorage()
+   */
+  static void operator delete(void * storage);
+
 protected:
   /**
    * This is needed to make base class polymorphic (i.e. have a vtable)
    */
   virtual void dummyMethod() {}
 
+  /**
+   * @brief Sets the name of the base class as typeid(BASE_CLASS).name() returns it
+   */
+  void setTypeidBaseClassName(const std::string & typeid_base_class_name);
+
+private:
+  struct OwnerBitWords;
+
+  /**
+   * @brief Gets the owner ID of a ClassLoader, i.e. its bit in the owner bitmap (@see allocateClassLoaderId()), 0 for nullptr.
+   */
+  static size_t getOwnerId(const ClassLoader * loader);
+
+  /**
+   * @brief Sets or clears the bit of an owner ID
+   */
+  void setOwnerBit(size_t owner_id, bool owned);
+
+  /**
+   * @brief Tests the bit of an owner ID
+   */
+  bool testOwnerBit(size_t owner_id) const;
+
 protected:
+  // Note: The owners are kept both as a list, to enumerate them, and as a bitmap indexed by owner
+  // ID, to test for them. The bits of the first 64 IDs are stored inline, the others in an array
+  // which is replaced by a larger copy under the global plugin map mutex when an ID does not fit.
+  // Replaced arrays are kept until the metaobject is destroyed, so that all bits are read without
+  // locking.
   ClassLoaderVector associated_class_loaders_;
-  std::string associated_library_path_;
-  std::string base_class_name_;
-  std::string class_name_;
-  std::string typeid_base_class_name_;
+  std::atomic<uint64_t> inline_owner_bits_;
+  std::atomic<const OwnerBitWords *> overflow_owner_bits_;
+  std::vector<std::unique_ptr<OwnerBitWords>> overflow_owner_bit_arrays_;
+  // Note: The names are interned (@see internSymbol()), so that all metaobjects share a single
+  // copy of each base class name and library path, which the symbol table never frees.
+  const std::string * associated_library_path_;
+  const std::string * base_class_name_;
+  const std::string * class_name_;
+  const std::string * typeid_base_class_name_;
+  SymbolId associated_library_id_;
+  SymbolId class_id_;
+  SymbolId typeid_base_class_id_;
+  // Note: Always present so that the layout does not depend on CLASS_LOADER_DISABLE_STATISTICS
+  mutable std::atomic<size_t> creation_count_;
+  mutable std::atomic<size_t> destruction_count_;
+};
+
+/**
+ * @brief The type the factories of classes derived from B which are constructed from arguments of types Args are registered under: B itself for default construction, the function type B(Args...) otherwise, so that factories are looked up by base class and constructor signature at once.
+ */
+template<class B, class ... Args>
+struct FactoryBaseType
+{
+  typedef B type(Args...);
+};
+
+template<class B>
+struct FactoryBaseType<B>
+{
+  typedef B type;
 };
 
 /**
  * @class AbstractMetaObject
+ * @brief Abstract base class for factories of classes constructed from arguments, where the polymorphic type variable indicates the base class for the plugin interface and the types of the constructor arguments. The arguments are taken by value type (i.e. without references or cv-qualifiers), as rvalue references.
+ * @parm B The base class interface for the plugin
+ * @parm Args The types of the constructor arguments
+ */
+template<class B, class ... Args>
+class AbstractMetaObject : public AbstractMetaObjectBase
+{
+  static_assert(
+    std::is_same<std::tuple<Args...>, std::tuple<typename std::decay<Args>::type...>>::value,
+    "Constructor arguments must be given as value types, without references or cv-qualifiers");
+
+public:
+  /**
+   * @brief A constructor for this class
+   * @param name The literal name of the class.
+   */
+  AbstractMetaObject(const std::string & class_name, const std::string & base_class_name)
+  : AbstractMetaObjectBase(class_name, base_class_name)
+  {
+    AbstractMetaObjectBase::setTypeidBaseClassName(
+      typeid(typename FactoryBaseType<B, Args...>::type).name());
+  }
+
+  /**
+   * @brief Defines the factory interface that the MetaObject must implement.
+   * @param args The constructor arguments, which are moved into the constructor
+   * @return A pointer of parametric type B to a newly created object.
+   */
+  virtual B * create(Args && ... args) const = 0;
+
+private:
+  AbstractMetaObject();
+  AbstractMetaObject(const AbstractMetaObject &);
+  AbstractMetaObject & operator=(const AbstractMetaObject &);
+};
+
+/**
  * @brief Abstract base class for factories where polymorphic type variable indicates base class for plugin interface.
  * @parm B The base class interface for the plugin
  */
 template<class B>
-class AbstractMetaObject : public AbstractMetaObjectBase
+class AbstractMetaObject<B> : public AbstractMetaObjectBase
 {
 public:
   /**
@@ -154,7 +326,7 @@ public:
   AbstractMetaObject(const std::string & class_name, const std::string & base_class_name)
   : AbstractMetaObjectBase(class_name, base_class_name)
   {
-    AbstractMetaObjectBase::typeid_base_class_name_ = std::string(typeid(B).name());
+    AbstractMetaObjectBase::setTypeidBaseClassName(typeid(B).name());
   }
 
   /**
@@ -165,6 +337,25 @@ public:
   /// Create a new instance of a class.
   /// Cannot be used for singletons.
 
+  /**
+   * @brief Constructs an object in caller provided storage, which must be at least
+   * getClassSize() bytes large and aligned to getClassAlignment(). The object must be destroyed
+   * by invoking its destructor rather than delete, after which the storage can be reused.
+   * @param storage The storage to construct the object in
+   * @return A pointer of parametric type B to the newly constructed object.
+   */
+  virtual B * create(void * storage) const = 0;
+
+  /**
+   * @brief Gets the size of the class this factory creates, i.e. sizeof(C)
+   */
+  virtual size_t getClassSize() const = 0;
+
+  /**
+   * @brief Gets the alignment of the class this factory creates, i.e. alignof(C)
+   */
+  virtual size_t getClassAlignment() const = 0;
+
 private:
   AbstractMetaObject();
   AbstractMetaObject(const AbstractMetaObject &);
@@ -173,12 +364,44 @@ private:
 
 /**
  * @class MetaObject
+ * @brief The actual factory of a class constructed from arguments.
+ * @parm C The derived class (the actual plugin)
+ * @parm B The base class interface for the plugin
+ * @parm Args The types of the constructor arguments
+ */
+template<class C, class B, class ... Args>
+class MetaObject : public AbstractMetaObject<B, Args...>
+{
+public:
+  /**
+   * @brief Constructor for the class
+   */
+  MetaObject(const std::string & class_name, const std::string & base_class_name)
+  : AbstractMetaObject<B, Args...>(class_name, base_class_name)
+  {
+  }
+
+  /**
+   * @brief The factory interface to generate an object, constructing it from the arguments. The object has type C in reality, though a pointer of the base class type is returned.
+   * @param args The constructor arguments
+   * @return A pointer to a newly created plugin with the base class type (type parameter B)
+   */
+  B * create(Args && ... args) const
+  {
+    ScopedTrace trace(TRACE_INSTANCE_CREATE, this->className());
+    B * obj = new C(std::forward<Args>(args)...);
+    this->countCreation();
+    return obj;
+  }
+};
+
+/**
  * @brief The actual factory.
  * @parm C The derived class (the actual plugin)
  * @parm B The base class interface for the plugin
  */
 template<class C, class B>
-class MetaObject : public AbstractMetaObject<B>
+class MetaObject<C, B> : public AbstractMetaObject<B>
 {
 public:
   /**
@@ -195,7 +418,33 @@ public:
    */
   B * create() const
   {
-    return new C;
+    ScopedTrace trace(TRACE_INSTANCE_CREATE, this->className());
+    B * obj = new C;
+    this->countCreation();
+    return obj;
+  }
+
+  /**
+   * @brief The factory interface to construct an object of type C in caller provided storage.
+   * @param storage Storage of at least sizeof(C) bytes aligned to alignof(C)
+   * @return A pointer to the newly constructed plugin with the base class type (type parameter B)
+   */
+  B * create(void * storage) const
+  {
+    ScopedTrace trace(TRACE_INSTANCE_CREATE, this->className());
+    B * obj = new (storage) C;
+    this->countCreation();
+    return obj;
+  }
+
+  size_t getClassSize() const
+  {
+    return sizeof(C);
+  }
+
+  size_t getClassAlignment() const
+  {
+    return alignof(C);
   }
 };
 
@@ -34,12 +34,19 @@
 
 #include <boost/thread.hpp>
 #include <cstddef>
+#include <cstdint>
+#include <future>
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
-#include "console_bridge/console.h"
 #include "class_loader/class_loader.hpp"
+#include "class_loader/logging.hpp"
 #include "class_loader/visibility_control.hpp"
 
 namespace class_loader
@@ -48,6 +55,38 @@ namespace class_loader
 typedef std::string LibraryPath;
 typedef std::map<LibraryPath, class_loader::ClassLoader *> LibraryToClassLoaderMap;
 typedef std::vector<ClassLoader *> ClassLoaderVector;
+typedef std::unordered_map<ClassId, class_loader::ClassLoader *> ClassToClassLoaderMap;
+typedef std::unordered_map<impl::SymbolId, ClassToClassLoaderMap> BaseToClassToClassLoaderMap;
+
+/**
+ * @brief The libraries each library depends on, in addition to the ones it links against, @see MultiLibraryClassLoader::loadLibrariesInDependencyOrder()
+ */
+typedef std::map<LibraryPath, std::vector<LibraryPath>> LibraryDependencyMap;
+
+/**
+ * @brief How a set of libraries was loaded, @see MultiLibraryClassLoader::loadLibrariesInDependencyOrder()
+ */
+struct LibraryLoadReport
+{
+  struct Library
+  {
+    std::string library_path;
+    /// The libraries of the set which had to be loaded before this one
+    std::vector<std::string> dependencies;
+    /// When the load of the library started and finished, relative to the start of the whole load
+    uint64_t start_time_ns;
+    uint64_t finish_time_ns;
+  };
+
+  /// The libraries that were loaded, in the order their loads started
+  std::vector<Library> libraries;
+  /// The chain of dependent libraries with the longest total load time, from the first library
+  /// loaded to the last. No number of threads can load the set faster than this chain.
+  std::vector<std::string> critical_path;
+  uint64_t critical_path_time_ns;
+  /// The time it took to load the whole set
+  uint64_t total_time_ns;
+};
 
 /**
 * @class MultiLibraryClassLoader
@@ -59,8 +98,10 @@ public:
   /**
    * @brief Constructor for the class
    * @param enable_ondemand_loadunload - Flag indicates if classes are to be loaded/unloaded automatically as class_loader are created and destroyed
+   * @param load_flags - A combination of LibraryLoadFlags the libraries are opened with
    */
-  explicit MultiLibraryClassLoader(bool enable_ondemand_loadunload);
+  explicit MultiLibraryClassLoader(
+    bool enable_ondemand_loadunload, int load_flags = LIBRARY_LOAD_DEFAULT);
 
   /**
   * @brief Virtual destructor for class
@@ -77,20 +118,21 @@ public:
   template<class Base>
   std::shared_ptr<Base> createSharedInstance(const std::string & class_name)
   {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader::MultiLibraryClassLoader: "
       "Attempting to create instance of class type %s.",
       class_name.c_str());
-    ClassLoader * loader = getClassLoaderForClass<Base>(class_name);
-    if (nullptr == loader) {
-      throw class_loader::CreateClassException(
-              "MultiLibraryClassLoader: Could not create object of class type " +
-              class_name +
-              " as no factory exists for it. Make sure that the library exists and "
-              "was explicitly loaded through MultiLibraryClassLoader::loadLibrary()");
-    }
-
-    return loader->createSharedInstance<Base>(class_name);
+    return withClassLoaderForClass<Base>(
+      class_name, [&class_name](ClassLoader * loader) {
+        if (nullptr == loader) {
+          throw class_loader::CreateClassException(
+                  "MultiLibraryClassLoader: Could not create object of class type " +
+                  class_name +
+                  " as no factory exists for it. Make sure that the library exists and "
+                  "was explicitly loaded through MultiLibraryClassLoader::loadLibrary()");
+        }
+        return loader->createSharedInstance<Base>(class_name);
+      });
   }
 
   /**
@@ -105,7 +147,7 @@ public:
   std::shared_ptr<Base>
   createSharedInstance(const std::string & class_name, const std::string & library_path)
   {
-    ClassLoader * loader = getClassLoaderForLibrary(library_path);
+    std::shared_ptr<ClassLoader> loader = shareClassLoaderForLibrary(library_path);
     if (nullptr == loader) {
       throw class_loader::NoClassLoaderExistsException(
               "Could not create instance as there is no ClassLoader in "
@@ -115,6 +157,97 @@ public:
     return loader->createSharedInstance<Base>(class_name);
   }
 
+  /**
+   * @brief Creates an instance of a class constructed from arguments, @see ClassLoader::createSharedInstance(). Unlike for ClassLoader, this is not an overload of createSharedInstance(), which would take a single string argument for a library path.
+   * @param Base - polymorphic type indicating base class
+   * @param class_name - the name of the concrete plugin class we want to instantiate
+   * @param args - the constructor arguments
+   * @return A std::shared_ptr<Base> to newly created plugin
+   */
+  template<class Base, class ... Args>
+  std::shared_ptr<Base>
+  createSharedInstanceWithArgs(const std::string & class_name, Args && ... args)
+  {
+    typedef typename impl::FactoryBaseType<Base, typename std::decay<Args>::type...>::type
+      Signature;
+    return withClassLoaderForClass<Signature>(
+      class_name, [&](ClassLoader * loader) {
+        if (nullptr == loader) {
+          throw class_loader::CreateClassException(
+                  "MultiLibraryClassLoader: Could not create object of class type " +
+                  class_name +
+                  " as no factory exists for it with these constructor arguments. Make sure "
+                  "that the library exists and was explicitly loaded through "
+                  "MultiLibraryClassLoader::loadLibrary()");
+        }
+        return loader->createSharedInstance<Base>(class_name, std::forward<Args>(args)...);
+      });
+  }
+
+  /**
+   * @brief Creates instances of several classes at once, finding the class loaders of all of them under a single lock and then creating the instances library by library, without holding the lock, @see ClassLoader::createSharedInstances()
+   * @param Base - polymorphic type indicating base class
+   * @param class_names - the names of the concrete plugin classes we want to instantiate, one instance is created per name
+   * @param num_threads - the number of threads to spread the construction of the instances across
+   * @return The std::shared_ptr<Base>s to the newly created plugins, in the order of the names
+   */
+  template<class Base>
+  std::vector<std::shared_ptr<Base>> createSharedInstances(
+    const std::vector<std::string> & class_names, size_t num_threads = 1)
+  {
+    return createSharedInstances<Base>(
+      class_names, std::vector<size_t>(class_names.size(), 1), num_threads);
+  }
+
+  /**
+   * @brief Same as createSharedInstances() but creates a number of instances per class
+   * @param Base - polymorphic type indicating base class
+   * @param class_names - the names of the concrete plugin classes we want to instantiate
+   * @param counts - the number of instances to create of each class, in the order of the names
+   * @param num_threads - the number of threads to spread the construction of the instances across
+   * @return The std::shared_ptr<Base>s to the newly created plugins, the instances of each class following those of the classes before it
+   */
+  template<class Base>
+  std::vector<std::shared_ptr<Base>> createSharedInstances(
+    const std::vector<std::string> & class_names, const std::vector<size_t> & counts,
+    size_t num_threads = 1)
+  {
+    if (class_names.size() != counts.size()) {
+      throw class_loader::CreateClassException(
+              "MultiLibraryClassLoader: Could not create instances as the numbers of class names "
+              "and counts differ");
+    }
+    std::vector<std::shared_ptr<ClassLoader>> loaders;
+    {
+      boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
+      for (auto & class_name : class_names) {
+        ClassLoader * loader = getIndexedClassLoaderForClass(
+          class_loader::impl::getBaseClassId<Base>(), class_name);
+        if (nullptr == loader) {
+          break;
+        }
+        loaders.push_back(shareClassLoader(loader));
+      }
+    }
+
+    if (loaders.size() != class_names.size()) {
+      // Some libraries are not indexed yet
+      loaders.clear();
+      boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+      for (auto & class_name : class_names) {
+        ClassLoader * loader = getClassLoaderForClass<Base>(class_name);
+        if (nullptr == loader) {
+          throw class_loader::CreateClassException(
+                  "MultiLibraryClassLoader: Could not create object of class type " + class_name +
+                  " as no factory exists for it. Make sure that the library exists and "
+                  "was explicitly loaded through MultiLibraryClassLoader::loadLibrary()");
+        }
+        loaders.push_back(shareClassLoader(loader));
+      }
+    }
+    return createSharedInstances<Base>(loaders, class_names, counts, num_threads);
+  }
+
   /**
    * @brief Creates an instance of an object of given class name with ancestor class Base
    * Same as createSharedInstance() except it returns a boost::shared_ptr.
@@ -122,20 +255,21 @@ public:
   template<class Base>
   boost::shared_ptr<Base> createInstance(const std::string & class_name)
   {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader::MultiLibraryClassLoader: "
       "Attempting to create instance of class type %s.",
       class_name.c_str());
-    ClassLoader * loader = getClassLoaderForClass<Base>(class_name);
-    if (nullptr == loader) {
-      throw class_loader::CreateClassException(
-              "MultiLibraryClassLoader: Could not create object of class type " +
-              class_name +
-              " as no factory exists for it. Make sure that the library exists and "
-              "was explicitly loaded through MultiLibraryClassLoader::loadLibrary()");
-    }
-
-    return loader->createInstance<Base>(class_name);
+    return withClassLoaderForClass<Base>(
+      class_name, [&class_name](ClassLoader * loader) {
+        if (nullptr == loader) {
+          throw class_loader::CreateClassException(
+                  "MultiLibraryClassLoader: Could not create object of class type " +
+                  class_name +
+                  " as no factory exists for it. Make sure that the library exists and "
+                  "was explicitly loaded through MultiLibraryClassLoader::loadLibrary()");
+        }
+        return loader->createInstance<Base>(class_name);
+      });
   }
 
   /**
@@ -146,7 +280,7 @@ public:
   boost::shared_ptr<Base>
   createInstance(const std::string & class_name, const std::string & library_path)
   {
-    ClassLoader * loader = getClassLoaderForLibrary(library_path);
+    std::shared_ptr<ClassLoader> loader = shareClassLoaderForLibrary(library_path);
     if (nullptr == loader) {
       throw class_loader::NoClassLoaderExistsException(
               "Could not create instance as there is no ClassLoader in "
@@ -163,18 +297,20 @@ public:
   template<class Base>
   ClassLoader::UniquePtr<Base> createUniqueInstance(const std::string & class_name)
   {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader::MultiLibraryClassLoader: Attempting to create instance of class type %s.",
       class_name.c_str());
-    ClassLoader * loader = getClassLoaderForClass<Base>(class_name);
-    if (nullptr == loader) {
-      throw class_loader::CreateClassException(
-              "MultiLibraryClassLoader: Could not create object of class type " + class_name +
-              " as no factory exists for it. "
-              "Make sure that the library exists and was explicitly loaded through "
-              "MultiLibraryClassLoader::loadLibrary()");
-    }
-    return loader->createUniqueInstance<Base>(class_name);
+    return withClassLoaderForClass<Base>(
+      class_name, [&class_name](ClassLoader * loader) {
+        if (nullptr == loader) {
+          throw class_loader::CreateClassException(
+                  "MultiLibraryClassLoader: Could not create object of class type " + class_name +
+                  " as no factory exists for it. "
+                  "Make sure that the library exists and was explicitly loaded through "
+                  "MultiLibraryClassLoader::loadLibrary()");
+        }
+        return loader->createUniqueInstance<Base>(class_name);
+      });
   }
 
   /**
@@ -185,7 +321,7 @@ public:
   ClassLoader::UniquePtr<Base>
   createUniqueInstance(const std::string & class_name, const std::string & library_path)
   {
-    ClassLoader * loader = getClassLoaderForLibrary(library_path);
+    std::shared_ptr<ClassLoader> loader = shareClassLoaderForLibrary(library_path);
     if (nullptr == loader) {
       throw class_loader::NoClassLoaderExistsException(
               "Could not create instance as there is no ClassLoader in "
@@ -206,12 +342,14 @@ public:
   template<class Base>
   Base * createUnmanagedInstance(const std::string & class_name)
   {
-    ClassLoader * loader = getClassLoaderForClass<Base>(class_name);
-    if (nullptr == loader) {
-      throw class_loader::CreateClassException(
-              "MultiLibraryClassLoader: Could not create class of type " + class_name);
-    }
-    return loader->createUnmanagedInstance<Base>(class_name);
+    return withClassLoaderForClass<Base>(
+      class_name, [&class_name](ClassLoader * loader) {
+        if (nullptr == loader) {
+          throw class_loader::CreateClassException(
+                  "MultiLibraryClassLoader: Could not create class of type " + class_name);
+        }
+        return loader->createUnmanagedInstance<Base>(class_name);
+      });
   }
 
   /**
@@ -225,7 +363,7 @@ public:
   template<class Base>
   Base * createUnmanagedInstance(const std::string & class_name, const std::string & library_path)
   {
-    ClassLoader * loader = getClassLoaderForLibrary(library_path);
+    std::shared_ptr<ClassLoader> loader = shareClassLoaderForLibrary(library_path);
     if (nullptr == loader) {
       throw class_loader::NoClassLoaderExistsException(
               "Could not create instance as there is no ClassLoader in MultiLibraryClassLoader "
@@ -244,9 +382,18 @@ public:
   template<class Base>
   bool isClassAvailable(const std::string & class_name)
   {
-    std::vector<std::string> available_classes = getAvailableClasses<Base>();
-    return available_classes.end() != std::find(
-      available_classes.begin(), available_classes.end(), class_name);
+    boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
+    if (nullptr != getIndexedClassLoaderForClass(
+        class_loader::impl::getBaseClassId<Base>(), class_name))
+    {
+      return true;
+    }
+    for (auto & it : active_class_loaders_) {
+      if (it.second->isClassAvailable<Base>(class_name)) {
+        return true;
+      }
+    }
+    return false;
   }
 
   /**
@@ -265,6 +412,7 @@ public:
   std::vector<std::string> getAvailableClasses()
   {
     std::vector<std::string> available_classes;
+    boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
     for (auto & loader : getAllAvailableClassLoaders()) {
       std::vector<std::string> loader_classes = loader->getAvailableClasses<Base>();
       available_classes.insert(
@@ -273,6 +421,20 @@ public:
     return available_classes;
   }
 
+  /**
+   * @brief Invokes a callback with the name of each class loaded by the class loader, same as getAvailableClasses() but without copying the names into a vector
+   * @param Base - polymorphic type indicating Base class
+   * @param callback - Invoked as callback(const std::string & class_name), the name is only valid during the call. The callback must not use this MultiLibraryClassLoader to load or unload libraries.
+   */
+  template<class Base, typename Callback>
+  void forEachAvailableClass(Callback && callback)
+  {
+    boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
+    for (auto & it : active_class_loaders_) {
+      it.second->forEachAvailableClass<Base>(callback);
+    }
+  }
+
   /**
    * @brief Gets a list of all classes loaded for a particular library
    * @param Base - polymorphic type indicating Base class
@@ -281,6 +443,7 @@ public:
   template<class Base>
   std::vector<std::string> getAvailableClassesForLibrary(const std::string & library_path)
   {
+    boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
     ClassLoader * loader = getClassLoaderForLibrary(library_path);
     if (nullptr == loader) {
       throw class_loader::NoClassLoaderExistsException(
@@ -303,12 +466,74 @@ public:
    */
   void loadLibrary(const std::string & library_path);
 
+  /**
+   * @brief Loads several libraries into memory for this class loader, opening them concurrently
+   * on a pool of worker threads. The outcome is the same as calling loadLibrary() for each of
+   * them in order: if a library fails to load, the libraries preceding it stay loaded, the ones
+   * following it are not loaded, and the exception is rethrown.
+   * @param library_paths - the fully qualified paths to the runtime libraries
+   */
+  void loadLibraries(const std::vector<std::string> & library_paths);
+
+  /**
+   * @brief Loads several libraries into memory for this class loader, opening each of them only once the libraries of the set it depends on are loaded, and opening libraries that do not depend on each other concurrently on a pool of worker threads. This keeps the factories a library registers from being attributed to a library depending on it that would pull it in. The dependencies are the libraries a library links against (@see impl::getNeededLibraries()), which match the libraries of the set with the same path or file name, along with the declared ones. Dependencies outside of the set are ignored. If a library fails to load, no further load is started, the libraries loaded so far stay loaded and the exception is rethrown. If the dependencies are cyclic, a LibraryLoadException is thrown before any library is loaded. Note that in on demand mode the libraries are only opened when first used, so this just creates their class loaders.
+   * @param library_paths - the fully qualified paths to the runtime libraries
+   * @param dependencies - the libraries each library depends on, in addition to the ones it links against
+   * @param num_threads - the number of threads to load the libraries with, 0 to use one per core
+   * @return How the libraries were loaded, including the critical path of the load
+   */
+  LibraryLoadReport loadLibrariesInDependencyOrder(
+    const std::vector<std::string> & library_paths,
+    const LibraryDependencyMap & dependencies = LibraryDependencyMap(), size_t num_threads = 0);
+
+  /**
+   * @brief Warms up the libraries providing some classes ahead of the first instances being created, @see ClassLoader::prefetch(). The class loaders of the classes are looked up and indexed right away, which opens the libraries without a manifest, the libraries are then loaded on background threads.
+   * @param Base - polymorphic type indicating base class
+   * @param class_names - the names of the classes
+   * @param prefault_pages - Set to true to also fault in the pages of the libraries
+   * @return A future that becomes ready once all libraries are warm, rethrowing the first failure
+   */
+  template<class Base>
+  std::shared_future<void>
+  warmUp(const std::vector<std::string> & class_names, bool prefault_pages = false)
+  {
+    std::vector<std::shared_future<void>> prefetched;
+    std::unordered_set<ClassLoader *> loaders;
+    for (auto & class_name : class_names) {
+      withClassLoaderForClass<Base>(
+        class_name, [&](ClassLoader * loader) {
+          if (nullptr == loader) {
+            throw class_loader::CreateClassException(
+                    "MultiLibraryClassLoader: Could not warm up class type " + class_name +
+                    " as no factory exists for it. Make sure that the library exists and "
+                    "was explicitly loaded through MultiLibraryClassLoader::loadLibrary()");
+          }
+          if (loaders.insert(loader).second) {
+            prefetched.push_back(loader->prefetch(prefault_pages));
+          }
+        });
+    }
+    return std::async(std::launch::deferred, [prefetched]() {
+               for (auto & future : prefetched) {
+                 future.get();
+               }
+             }).share();
+  }
+
   /**
    * @brief Unloads a library for this class loader
    * @param library_path - the fully qualified path to the runtime library
    */
   int unloadLibrary(const std::string & library_path);
 
+  /**
+   * @brief Replaces a loaded library with the new build of it found at its path, without stalling the creation of instances. The new build is opened from a copy (@see impl::createLibrarySnapshot()) alongside the old one and its factories are staged (@see impl::ScopedStagedRegistration), all without holding a lock. Then, under a brief exclusive lock, its factories replace those of the old build, so that instances created afterwards come from the new build. The old build is retired (@see ClassLoader::retireLibrary()) and unloaded once its last instance is destroyed. The library stays registered under its path and stays loaded until unloaded or replaced, even in on demand mode. A library that is not loaded yet is simply loaded.
+   * @param library_path - the fully qualified path to the runtime library
+   * @param load_flags - flags added to the LibraryLoadFlags of this class loader for the new build
+   * @throws LibraryLoadException if the new build exports symbols that the old build exports as well (@see impl::getSymbolsInterposedByLibrary()), unless opened with LIBRARY_LOAD_DEEPBIND. Like any library opened with RTLD_GLOBAL, it would bind its references to them (e.g. calls of non-inline functions of default visibility) to the old build and run old code, so reloadable libraries have to be built with hidden symbols, e.g. with class_loader_hide_library_symbols().
+   */
+  void reloadLibrary(const std::string & library_path, int load_flags = LIBRARY_LOAD_DEFAULT);
+
 private:
   /**
    * @brief Indicates if on-demand (lazy) load/unload is enabled so libraries are loaded/unloaded automatically as needed
@@ -316,34 +541,189 @@ private:
   bool isOnDemandLoadUnloadEnabled() {return enable_ondemand_loadunload_;}
 
   /**
-   * @brief Gets a handle to the class loader corresponding to a specific runtime library
+   * @brief Gets a handle to the class loader corresponding to a specific runtime library, loader_mutex_ must be locked
    * @param library_path - the library from which we want to create the plugin
    * @return A pointer to the ClassLoader*, == nullptr if not found
    */
   ClassLoader * getClassLoaderForLibrary(const std::string & library_path);
 
   /**
-   * @brief Gets a handle to the class loader corresponding to a specific class
+   * @brief Shares the ownership of a class loader, so that it is not destroyed while used without holding loader_mutex_, which must be locked
+   * @param loader - The class loader, nullptr to get nullptr
+   */
+  std::shared_ptr<ClassLoader> shareClassLoader(ClassLoader * loader);
+
+  /**
+   * @brief Shares the ownership of the class loader corresponding to a specific runtime library, @see shareClassLoader()
+   * @param library_path - the library from which we want to create the plugin
+   * @return The ClassLoader, == nullptr if not found
+   */
+  std::shared_ptr<ClassLoader> shareClassLoaderForLibrary(const std::string & library_path);
+
+  /**
+   * @brief Invokes a function with the class loader corresponding to a specific class.
+   *
+   * Finding the class loader takes a shared lock if the class is indexed already, otherwise it may
+   * index more libraries and takes an exclusive lock. The function runs without holding the lock,
+   * so that plugins may create other plugins through this class loader from their constructors,
+   * and shares the ownership of the class loader meanwhile (@see shareClassLoader()).
+   *
+   * @param class_name - name of class for which we want to create instance
+   * @param function - the function to invoke with the ClassLoader*, == nullptr if not found
+   * @return The result of the function
+   */
+  template<typename Base, typename Function>
+  auto withClassLoaderForClass(const std::string & class_name, Function function)
+  -> decltype(function(static_cast<ClassLoader *>(nullptr)))
+  {
+    std::shared_ptr<ClassLoader> loader;
+    {
+      boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
+      loader = shareClassLoader(getIndexedClassLoaderForClass(
+          class_loader::impl::getBaseClassId<Base>(), class_name));
+    }
+    if (nullptr == loader) {
+      boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+      loader = shareClassLoader(getClassLoaderForClass<Base>(class_name));
+    }
+    return function(loader.get());
+  }
+
+  /**
+   * @brief Gets a handle to the class loader corresponding to a specific class, loader_mutex_ must be locked exclusively
    * @param class_name - name of class for which we want to create instance
    * @return A pointer to the ClassLoader*, == nullptr if not found
    */
   template<typename Base>
   ClassLoader * getClassLoaderForClass(const std::string & class_name)
   {
+    ClassLoader * loader = getIndexedClassLoaderForClass(
+      class_loader::impl::getBaseClassId<Base>(), class_name);
+    if (nullptr != loader) {
+      return loader;
+    }
+
+    // Libraries which have not been loaded through this class loader yet are not indexed
     ClassLoaderVector loaders = getAllAvailableClassLoaders();
-    for (ClassLoaderVector::iterator i = loaders.begin(); i != loaders.end(); ++i) {
-      if (!(*i)->isLibraryLoaded()) {
-        (*i)->loadLibrary();
+    ClassLoaderVector unlisted_loaders;
+    for (auto & candidate : loaders) {
+      if (isClassLoaderIndexed(candidate)) {
+        continue;
       }
-      if ((*i)->isClassAvailable<Base>(class_name)) {
-        return *i;
+      if (!candidate->isLibraryLoaded()) {
+        // The manifest tells whether the library provides the class without loading it, except
+        // for classes constructed from arguments, which it does not list
+        bool listed = false;
+        if (!std::is_function<Base>::value && candidate->isOnDemandLoadUnloadEnabled() &&
+          class_loader::impl::forEachManifestClassForLibrary(
+            candidate->getLibraryPath(), typeid(Base).name(),
+            [&listed, &class_name](const std::string & manifest_class_name) {
+              listed = listed || manifest_class_name == class_name;
+            }))
+        {
+          if (listed) {
+            return candidate;
+          }
+          unlisted_loaders.push_back(candidate);
+          continue;
+        }
+        candidate->loadLibrary();
+      }
+      indexClassLoader(candidate);
+      if (candidate->isClassAvailable<Base>(class_name)) {
+        return candidate;
+      }
+    }
+
+    // The manifests miss classes registered in ways their generator does not recognize, so the
+    // libraries whose manifest does not list the class are opened if no other library provides it
+    for (auto & candidate : unlisted_loaders) {
+      candidate->loadLibrary();
+      indexClassLoader(candidate);
+      if (candidate->isClassAvailable<Base>(class_name)) {
+        return candidate;
+      }
+    }
+
+    // Factories registered outside of any ClassLoader (e.g. by a non-pure plugin library opened
+    // before main()) are not associated with a library and cannot be indexed
+    for (auto & candidate : loaders) {
+      if (candidate->isClassAvailable<Base>(class_name)) {
+        return candidate;
       }
     }
     return nullptr;
   }
 
   /**
-   * @brief Gets all class loaders loaded within scope
+   * @brief Creates the instances of createSharedInstances() with the class loaders of the classes, loader_mutex_ must not be locked
+   * @param loaders - the class loader of each class
+   */
+  template<typename Base>
+  std::vector<std::shared_ptr<Base>> createSharedInstances(
+    const std::vector<std::shared_ptr<ClassLoader>> & loaders,
+    const std::vector<std::string> & class_names, const std::vector<size_t> & counts,
+    size_t num_threads)
+  {
+    // The classes of each class loader, with the position of their first instance in the result
+    struct LoaderClasses
+    {
+      std::vector<std::string> class_names;
+      std::vector<size_t> counts;
+      std::vector<size_t> positions;
+    };
+    std::unordered_map<ClassLoader *, LoaderClasses> classes_by_loader;
+    size_t num_instances = 0;
+    for (size_t i = 0; i < class_names.size(); ++i) {
+      LoaderClasses & classes = classes_by_loader[loaders[i].get()];
+      classes.class_names.push_back(class_names[i]);
+      classes.counts.push_back(counts[i]);
+      classes.positions.push_back(num_instances);
+      num_instances += counts[i];
+    }
+
+    std::vector<std::shared_ptr<Base>> instances(num_instances);
+    for (auto & it : classes_by_loader) {
+      ClassLoader * loader = it.first;
+      LoaderClasses & classes = it.second;
+      std::vector<std::shared_ptr<Base>> loader_instances =
+        loader->createSharedInstances<Base>(classes.class_names, classes.counts, num_threads);
+      auto next = loader_instances.begin();
+      for (size_t i = 0; i < classes.positions.size(); ++i) {
+        std::move(next, next + classes.counts[i], instances.begin() + classes.positions[i]);
+        next += classes.counts[i];
+      }
+    }
+    return instances;
+  }
+
+  /**
+   * @brief Looks up the class loader of a class in the index built from the libraries loaded so far
+   * @param typeid_base_class_id - The interned ID of typeid(Base).name() for the base class
+   * @param class_name - name of class for which we want to create instance
+   * @return A pointer to the ClassLoader*, == nullptr if not found
+   */
+  ClassLoader * getIndexedClassLoaderForClass(
+    impl::SymbolId typeid_base_class_id, const std::string & class_name);
+
+  /**
+   * @brief Indicates if the classes of a class loader's library have been indexed
+   */
+  bool isClassLoaderIndexed(ClassLoader * loader);
+
+  /**
+   * @brief Indexes the classes of a class loader's library, which must be loaded.
+   * Classes already provided by a previously indexed library are not overridden.
+   */
+  void indexClassLoader(ClassLoader * loader);
+
+  /**
+   * @brief Removes the classes of a class loader's library from the index
+   */
+  void unindexClassLoader(ClassLoader * loader);
+
+  /**
+   * @brief Gets all class loaders loaded within scope, loader_mutex_ must be locked
    */
   ClassLoaderVector getAllAvailableClassLoaders();
 
@@ -352,10 +732,35 @@ private:
    */
   void shutdownAllClassLoaders();
 
+  /**
+   * @brief Registers a ClassLoader for a library, taking ownership of it and indexing it if its library is loaded, loader_mutex_ must be locked exclusively
+   */
+  void registerClassLoader(const std::string & library_path, ClassLoader * loader);
+
+  /**
+   * @brief Destroys a ClassLoader registered for a library, discarding the snapshot it is bound to if it was reloaded
+   */
+  static void destroyClassLoader(const std::string & library_path, ClassLoader * loader);
+
+  /**
+   * @brief Destroys the retired ClassLoaders whose library was unloaded, @see reloadLibrary()
+   * @param force - Destroys all of them instead, leaking the ones whose instances still exist
+   */
+  void destroyRetiredClassLoaders(bool force = false);
+
 private:
   bool enable_ondemand_loadunload_;
+  int load_flags_;
   LibraryToClassLoaderMap active_class_loaders_;
-  boost::mutex loader_mutex_;
+  BaseToClassToClassLoaderMap class_loader_index_;
+  std::unordered_set<ClassLoader *> indexed_class_loaders_;
+  // Own the class loaders of active_class_loaders_, instances are created with a share of the
+  // ownership so that unloads and reloads destroy a class loader only once it is no longer used
+  std::unordered_map<ClassLoader *, std::shared_ptr<ClassLoader>> class_loader_owners_;
+  // The class loaders of the builds replaced by reloadLibrary()
+  std::vector<std::shared_ptr<ClassLoader>> retired_class_loaders_;
+  // Guards the class loaders and the index, which are only modified under exclusive locks
+  boost::shared_mutex loader_mutex_;
 };
 
 
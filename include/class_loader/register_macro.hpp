@@ -33,8 +33,19 @@
 #include <string>
 
 #include "class_loader/class_loader_core.hpp"
-#include "console_bridge/console.h"
+#include "class_loader/logging.hpp"
 
+#ifdef CLASS_LOADER_STATIC_REGISTRY
+#include "class_loader/static_registry.hpp"
+
+// Classes go into the static registry, there is nothing to log the message at
+#define CLASS_LOADER_REGISTER_CLASS_INTERNAL_WITH_MESSAGE(Derived, Base, UniqueID, Message) \
+  CLASS_LOADER_REGISTER_STATIC_CLASS_INTERNAL(Derived, Base, UniqueID)
+
+#define CLASS_LOADER_REGISTER_CLASS_INTERNAL_WITH_ARGS(Derived, Base, UniqueID, ...) \
+  static_assert( \
+    sizeof(Derived) == 0, "The static registry only holds default constructible classes");
+#else
 #define CLASS_LOADER_REGISTER_CLASS_INTERNAL_WITH_MESSAGE(Derived, Base, UniqueID, Message) \
   namespace \
   { \
@@ -45,13 +56,32 @@
     ProxyExec ## UniqueID() \
     { \
       if (!std::string(Message).empty()) { \
-        CONSOLE_BRIDGE_logInform("%s", Message);} \
+        CLASS_LOADER_LOG_INFORM("%s", Message);} \
       class_loader::impl::registerPlugin<_derived, _base>(#Derived, #Base); \
     } \
   }; \
   static ProxyExec ## UniqueID g_register_plugin_ ## UniqueID; \
   }  // namespace
 
+#define CLASS_LOADER_REGISTER_CLASS_INTERNAL_WITH_ARGS(Derived, Base, UniqueID, ...) \
+  namespace \
+  { \
+  struct ProxyExec ## UniqueID \
+  { \
+    typedef  Derived _derived; \
+    typedef  Base _base; \
+    ProxyExec ## UniqueID() \
+    { \
+      class_loader::impl::registerPlugin<_derived, _base, __VA_ARGS__>(#Derived, #Base); \
+    } \
+  }; \
+  static ProxyExec ## UniqueID g_register_plugin_ ## UniqueID; \
+  }  // namespace
+#endif
+
+#define CLASS_LOADER_REGISTER_CLASS_INTERNAL_HOP1_WITH_ARGS(Derived, Base, UniqueID, ...) \
+  CLASS_LOADER_REGISTER_CLASS_INTERNAL_WITH_ARGS(Derived, Base, UniqueID, __VA_ARGS__)
+
 #define CLASS_LOADER_REGISTER_CLASS_INTERNAL_HOP1_WITH_MESSAGE(Derived, Base, UniqueID, Message) \
   CLASS_LOADER_REGISTER_CLASS_INTERNAL_WITH_MESSAGE(Derived, Base, UniqueID, Message)
 
@@ -64,9 +94,16 @@
 
 /**
 * @macro This is the macro which must be declared within the source (.cpp) file for each class that is to be exported as plugin.
+* When CLASS_LOADER_STATIC_REGISTRY is defined, the class is added to the static registry instead (@see CLASS_LOADER_REGISTER_STATIC_CLASS).
 * The macro utilizes a trick where a new struct is generated along with a declaration of static global variable of same type after it. The struct's constructor invokes a registration function with the plugin system. When the plugin system loads a library with registered classes in it, the initialization of static variables forces the invocation of the struct constructors, and all exported classes are automatically registerd.
 */
 #define CLASS_LOADER_REGISTER_CLASS(Derived, Base) \
   CLASS_LOADER_REGISTER_CLASS_WITH_MESSAGE(Derived, Base, "")
 
+/**
+* @macro This macro registers a class that is constructed from arguments of the given types rather than default constructed, e.g. CLASS_LOADER_REGISTER_CLASS_WITH_ARGS(Robot, Base, std::string, int). The types are value types, any references or cv-qualifiers of the constructor parameters left out. Instances are created with ClassLoader::createSharedInstance<Base>(class_name, args...) and the like, which forward the arguments to the constructor. The class is registered under its base class and the argument types, so it is not listed by getAvailableClasses<Base>(), and a class may be registered both with and without arguments.
+*/
+#define CLASS_LOADER_REGISTER_CLASS_WITH_ARGS(Derived, Base, ...) \
+  CLASS_LOADER_REGISTER_CLASS_INTERNAL_HOP1_WITH_ARGS(Derived, Base, __COUNTER__, __VA_ARGS__)
+
 #endif  // CLASS_LOADER__REGISTER_MACRO_HPP_
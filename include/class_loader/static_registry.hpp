@@ -0,0 +1,237 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CLASS_LOADER__STATIC_REGISTRY_HPP_
+#define CLASS_LOADER__STATIC_REGISTRY_HPP_
+
+#include <boost/shared_ptr.hpp>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "class_loader/exceptions.hpp"
+
+#if !defined(__ELF__)
+#error "The class_loader static registry requires an ELF toolchain (e.g. GCC or Clang on Linux)"
+#endif
+
+/**
+ * The static registry is meant for plugins linked statically into an executable, e.g. on embedded
+ * targets without a dynamic loader. Classes registered with CLASS_LOADER_REGISTER_STATIC_CLASS()
+ * (or with CLASS_LOADER_REGISTER_CLASS() in translation units built with
+ * CLASS_LOADER_STATIC_REGISTRY defined) end up in a constant table which the linker collects into
+ * the class_loader_static_registry section. Nothing runs at startup, no metaobject is allocated
+ * and no library is opened: StaticClassLoader just walks the table.
+ *
+ * Note: As for any static plugin, the linker drops object files nothing refers to, so static
+ * libraries of plugins must be linked with --whole-archive (or as object libraries).
+ */
+
+namespace class_loader
+{
+namespace impl
+{
+
+/**
+ * @brief An entry of the static registry, one per registered class
+ */
+struct StaticClassEntry
+{
+  const char * class_name;
+  const char * base_class_name;
+  const std::type_info * base_class_type;
+  /// Creates an instance of the class, returning it as a pointer to the base class cast to void *
+  void * (*create)();
+};
+
+/**
+ * @brief The factory function of a class in the static registry
+ */
+template<class Derived, class Base>
+void * createStaticInstance()
+{
+  return static_cast<Base *>(new Derived);
+}
+
+}  // namespace impl
+}  // namespace class_loader
+
+// The linker defines these for sections named like C identifiers. They are weak as they do not
+// exist if nothing was registered, and hidden so that each module only sees its own table.
+extern "C" {
+extern const class_loader::impl::StaticClassEntry __start_class_loader_static_registry[]  // NOLINT
+__attribute__((weak, visibility("hidden")));
+extern const class_loader::impl::StaticClassEntry __stop_class_loader_static_registry[]  // NOLINT
+__attribute__((weak, visibility("hidden")));
+}
+
+namespace class_loader
+{
+
+/**
+ * @class StaticClassLoader
+ * @brief Creates objects of the classes in the static registry of the executable or library it is used in, with the same interface as ClassLoader for creating objects. There is nothing to load or unload, so the objects are simply deleted when they go out of scope.
+ */
+class StaticClassLoader
+{
+public:
+  template<typename Base>
+  using UniquePtr = std::unique_ptr<Base>;
+
+  /**
+   * @brief  Indicates which classes derived from Base are in the static registry
+   * @return vector of strings indicating names of instantiable classes derived from <Base>
+   */
+  template<class Base>
+  std::vector<std::string> getAvailableClasses() const
+  {
+    std::vector<std::string> classes;
+    for (const impl::StaticClassEntry * entry = begin(); entry != end(); ++entry) {
+      if (*entry->base_class_type == typeid(Base)) {
+        classes.push_back(entry->class_name);
+      }
+    }
+    return classes;
+  }
+
+  /**
+   * @brief Indicates if a plugin class is in the static registry
+   * @param class_name - the name of the plugin class
+   * @return true if yes it is available, false otherwise
+   */
+  template<class Base>
+  bool isClassAvailable(const std::string & class_name) const
+  {
+    return nullptr != findEntry<Base>(class_name);
+  }
+
+  /**
+   * @brief  Generates an instance of a class in the static registry
+   * @param  derived_class_name The name of the class we want to create (@see getAvailableClasses())
+   * @return A std::shared_ptr<Base> to newly created plugin object
+   */
+  template<class Base>
+  std::shared_ptr<Base> createSharedInstance(const std::string & derived_class_name) const
+  {
+    return std::shared_ptr<Base>(createRawInstance<Base>(derived_class_name));
+  }
+
+  /**
+   * @brief  Generates an instance of a class in the static registry
+   *
+   * Same as createSharedInstance() except it returns a boost::shared_ptr.
+   */
+  template<class Base>
+  boost::shared_ptr<Base> createInstance(const std::string & derived_class_name) const
+  {
+    return boost::shared_ptr<Base>(createRawInstance<Base>(derived_class_name));
+  }
+
+  /**
+   * @brief  Generates an instance of a class in the static registry
+   *
+   * Same as createSharedInstance() except it returns a std::unique_ptr.
+   */
+  template<class Base>
+  UniquePtr<Base> createUniqueInstance(const std::string & derived_class_name) const
+  {
+    return UniquePtr<Base>(createRawInstance<Base>(derived_class_name));
+  }
+
+  /**
+   * @brief  Generates an instance of a class in the static registry, which the caller has to delete
+   * @param derived_class_name The name of the class we want to create (@see getAvailableClasses())
+   * @return An unmanaged (i.e. not a shared_ptr) Base* to newly created plugin object.
+   */
+  template<class Base>
+  Base * createUnmanagedInstance(const std::string & derived_class_name) const
+  {
+    return createRawInstance<Base>(derived_class_name);
+  }
+
+private:
+  __attribute__((visibility("hidden")))
+  static const impl::StaticClassEntry * begin()
+  {
+    return __start_class_loader_static_registry;
+  }
+
+  __attribute__((visibility("hidden")))
+  static const impl::StaticClassEntry * end()
+  {
+    return __stop_class_loader_static_registry;
+  }
+
+  template<class Base>
+  const impl::StaticClassEntry * findEntry(const std::string & class_name) const
+  {
+    for (const impl::StaticClassEntry * entry = begin(); entry != end(); ++entry) {
+      if (class_name == entry->class_name && *entry->base_class_type == typeid(Base)) {
+        return entry;
+      }
+    }
+    return nullptr;
+  }
+
+  template<class Base>
+  Base * createRawInstance(const std::string & derived_class_name) const
+  {
+    const impl::StaticClassEntry * entry = findEntry<Base>(derived_class_name);
+    if (nullptr == entry) {
+      throw class_loader::CreateClassException(
+              "Could not create instance of type " + derived_class_name);
+    }
+    return static_cast<Base *>(entry->create());
+  }
+};
+
+}  // namespace class_loader
+
+#define CLASS_LOADER_REGISTER_STATIC_CLASS_INTERNAL(Derived, Base, UniqueID) \
+  namespace \
+  { \
+  __attribute__((used, section("class_loader_static_registry"))) \
+  const class_loader::impl::StaticClassEntry g_static_plugin_ ## UniqueID = { \
+    #Derived, #Base, &typeid(Base), &class_loader::impl::createStaticInstance<Derived, Base> \
+  }; \
+  }  // namespace
+
+#define CLASS_LOADER_REGISTER_STATIC_CLASS_INTERNAL_HOP1(Derived, Base, UniqueID) \
+  CLASS_LOADER_REGISTER_STATIC_CLASS_INTERNAL(Derived, Base, UniqueID)
+
+/**
+* @macro This macro adds a class to the static registry (@see StaticClassLoader) instead of registering it with the plugin system when its library is loaded.
+*/
+#define CLASS_LOADER_REGISTER_STATIC_CLASS(Derived, Base) \
+  CLASS_LOADER_REGISTER_STATIC_CLASS_INTERNAL_HOP1(Derived, Base, __COUNTER__)
+
+#endif  // CLASS_LOADER__STATIC_REGISTRY_HPP_
@@ -0,0 +1,180 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CLASS_LOADER__TRACER_HPP_
+#define CLASS_LOADER__TRACER_HPP_
+
+#include <boost/thread/mutex.hpp>
+#include <atomic>
+#include <fstream>
+#include <string>
+
+#include "class_loader/visibility_control.hpp"
+
+namespace class_loader
+{
+namespace impl
+{
+
+/**
+ * @brief The spans of the plugin system reported to a Tracer, @see setTracer()
+ */
+enum TraceEvent
+{
+  /// A library being opened, which includes running its static initializers (i.e. registrations)
+  TRACE_LIBRARY_OPEN,
+  /// A library being closed, which includes running its static destructors
+  TRACE_LIBRARY_CLOSE,
+  /// The registration of the factory of a class as its library is opened
+  TRACE_REGISTRATION,
+  /// The factories of a reopened library which did not register them again being revived from the
+  /// graveyard, or the stale factories of a library which did being purged from it
+  TRACE_GRAVEYARD_REVIVE,
+  TRACE_GRAVEYARD_PURGE,
+  /// An instance of a class being constructed, or a managed one being destroyed, the latter
+  /// including the unload of the library if it was the last instance in on demand mode
+  TRACE_INSTANCE_CREATE,
+  TRACE_INSTANCE_DESTROY
+};
+
+/**
+ * @brief Gets the name of a TraceEvent, e.g. "library_open"
+ */
+CLASS_LOADER_PUBLIC
+const char * getTraceEventName(TraceEvent event);
+
+/**
+ * @class Tracer
+ * @brief Receives the spans of the plugin system, to put them on the timeline of a tracing system. The callbacks are invoked on the thread the span is on, which may be holding mutexes of the plugin system, so they must neither block for long nor use the plugin system.
+ */
+class CLASS_LOADER_PUBLIC Tracer
+{
+public:
+  virtual ~Tracer();
+
+  /**
+   * @brief Invoked as a span begins, spans on the same thread are properly nested
+   * @param event - The kind of span
+   * @param name - The path of the library for library and graveyard spans, the name of the class otherwise, only valid during the call
+   */
+  virtual void begin(TraceEvent event, const char * name) = 0;
+
+  /**
+   * @brief Invoked as the innermost span of the thread begun with begin() ends
+   * @param event - The kind of span
+   * @param name - The same name as passed to begin()
+   */
+  virtual void end(TraceEvent event, const char * name) = 0;
+};
+
+/**
+ * @brief Gets a handle to the tracer in use, @see setTracer()
+ */
+CLASS_LOADER_PUBLIC
+std::atomic<Tracer *> & getTracerReference();
+
+/**
+ * @brief Installs the tracer spans are reported to from now on, tracing is disabled again with nullptr. Spans that have begun are ended with the tracer they began with, so it must stay alive until those are done. Costs a single atomic load per span if no tracer is installed, and nothing if CLASS_LOADER_DISABLE_TRACING is defined.
+ * @param tracer - The tracer, or nullptr
+ */
+CLASS_LOADER_PUBLIC
+void setTracer(Tracer * tracer);
+
+/**
+ * @class ScopedTrace
+ * @brief Reports a span to the installed tracer for the lifetime of the object, @see setTracer(). The name must outlive the object.
+ */
+class ScopedTrace
+{
+public:
+  ScopedTrace(TraceEvent event, const std::string & name)
+#ifndef CLASS_LOADER_DISABLE_TRACING
+  : tracer_(getTracerReference().load(std::memory_order_acquire)), event_(event), name_(name)
+#else
+  : tracer_(nullptr), event_(event), name_(name)
+#endif
+  {
+    if (nullptr != tracer_) {
+      tracer_->begin(event_, name_.c_str());
+    }
+  }
+
+  ~ScopedTrace()
+  {
+    if (nullptr != tracer_) {
+      tracer_->end(event_, name_.c_str());
+    }
+  }
+
+  ScopedTrace(const ScopedTrace &) = delete;
+  ScopedTrace & operator=(const ScopedTrace &) = delete;
+
+private:
+  // Note: Always present so that the layout does not depend on CLASS_LOADER_DISABLE_TRACING
+  Tracer * tracer_;
+  TraceEvent event_;
+  // Note: Not copied, the names traced are those of libraries and factories, which outlive spans
+  const std::string & name_;
+};
+
+/**
+ * @class TraceEventFileTracer
+ * @brief A Tracer writing the spans to a file in the JSON Trace Event Format, which the Perfetto UI, its trace processor and chrome://tracing open. Timestamps are taken from the steady clock (CLOCK_MONOTONIC on Linux) and threads are identified by their kernel thread IDs, so that the spans line up with a system trace of the same process.
+ */
+class CLASS_LOADER_PUBLIC TraceEventFileTracer : public Tracer
+{
+public:
+  /**
+   * @brief Opens the file, throws class_loader::ClassLoaderException if it cannot be written
+   * @param path - The path of the file, which is overwritten
+   */
+  explicit TraceEventFileTracer(const std::string & path);
+
+  /**
+   * @brief Completes and closes the file, the tracer must not be installed anymore
+   */
+  virtual ~TraceEventFileTracer();
+
+  void begin(TraceEvent event, const char * name);
+  void end(TraceEvent event, const char * name);
+
+private:
+  void write(TraceEvent event, const char * name, char phase);
+
+  boost::mutex mutex_;
+  std::ofstream file_;
+  bool has_events_;
+};
+
+}  // namespace impl
+}  // namespace class_loader
+
+#endif  // CLASS_LOADER__TRACER_HPP_
@@ -29,9 +29,16 @@
 
 #include "class_loader/class_loader.hpp"
 
+#include <boost/align/aligned_alloc.hpp>
+#include <chrono>
+#include <future>
+#include <new>
 #include <string>
+#include <vector>
 
+#ifdef CLASS_LOADER_USE_POCO
 #include "Poco/SharedLibrary.h"
+#endif
 
 namespace class_loader
 {
@@ -53,7 +60,15 @@ std::string systemLibraryPrefix()
 
 std::string systemLibrarySuffix()
 {
+#ifdef CLASS_LOADER_USE_POCO
   return Poco::SharedLibrary::suffix();
+#elif defined(_WIN32)
+  return ".dll";
+#elif defined(__APPLE__)
+  return ".dylib";
+#else
+  return ".so";
+#endif
 }
 
 
@@ -62,13 +77,20 @@ std::string systemLibraryFormat(const std::string & library_name)
   return systemLibraryPrefix() + library_name + systemLibrarySuffix();
 }
 
-ClassLoader::ClassLoader(const std::string & library_path, bool ondemand_load_unload)
+ClassLoader::ClassLoader(
+  const std::string & library_path, bool ondemand_load_unload, int load_flags)
 : ondemand_load_unload_(ondemand_load_unload),
+  load_flags_(load_flags),
   library_path_(library_path),
   load_ref_count_(0),
-  plugin_ref_count_(0)
+  plugin_ref_count_(0),
+  library_generation_(0),
+  unload_grace_period_(std::chrono::steady_clock::duration::zero()),
+  unload_pending_(false),
+  retired_(false),
+  owner_id_(class_loader::impl::allocateClassLoaderId())
 {
-  CONSOLE_BRIDGE_logDebug(
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.ClassLoader: "
     "Constructing new ClassLoader (%p) bound to library %s.",
     this, library_path.c_str());
@@ -79,15 +101,28 @@ ClassLoader::ClassLoader(const std::string & library_path, bool ondemand_load_un
 
 ClassLoader::~ClassLoader()
 {
-  CONSOLE_BRIDGE_logDebug("%s",
+  CLASS_LOADER_LOG_DEBUG("%s",
     "class_loader.ClassLoader: "
     "Destroying class loader, unloading associated library...\n");
+  // Note: Waits for the unload reaper in case it is unloading the library right now
+  class_loader::impl::cancelDeferredUnload(this, true);
+  if (prefetched_.valid()) {
+    prefetched_.wait();
+  }
   unloadLibrary();  // TODO(mikaelarguedas): while(unloadLibrary() > 0){} ??
+  purgePooledStorage();
+  // Note: If plugins outlive their ClassLoader, the library stays loaded with metaobjects still
+  // owned by it, so its ID must not be handed to another ClassLoader.
+  if (class_loader::impl::getAllLibrariesUsedByClassLoader(this).empty()) {
+    class_loader::impl::freeClassLoaderId(owner_id_);
+  }
 }
 
 bool ClassLoader::isLibraryLoaded()
 {
-  return class_loader::impl::isLibraryLoaded(getLibraryPath(), this);
+  // Note: The library stays loaded for this ClassLoader as long as it holds a load reference
+  return load_ref_count_.load() > 0 ||
+         class_loader::impl::isLibraryLoaded(getLibraryPath(), this);
 }
 
 bool ClassLoader::isLibraryLoadedByAnyClassloader()
@@ -97,9 +132,41 @@ bool ClassLoader::isLibraryLoadedByAnyClassloader()
 
 void ClassLoader::loadLibrary()
 {
+  // Already loaded on behalf of this ClassLoader, which cannot change while we hold a reference
+  int load_ref_count = load_ref_count_.load();
+  while (load_ref_count > 0) {
+    if (load_ref_count_.compare_exchange_weak(load_ref_count, load_ref_count + 1)) {
+      return;
+    }
+  }
+
   boost::recursive_mutex::scoped_lock lock(load_ref_count_mutex_);
-  load_ref_count_ = load_ref_count_ + 1;
   class_loader::impl::loadLibrary(getLibraryPath(), this);
+  ++load_ref_count_;
+}
+
+std::shared_future<void> ClassLoader::prefetch(bool prefault_pages)
+{
+  boost::recursive_mutex::scoped_lock lock(load_ref_count_mutex_);
+  if (prefetched_.valid() &&
+    prefetched_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    return prefetched_;
+  }
+  // Note: As this ClassLoader keeps a reference to the future, dropping the one returned does
+  // not block until the prefetch is done
+  prefetched_ = std::async(std::launch::async, [this, prefault_pages]() {
+        // Note: Holding the mutex keeps the library from being unloaded while faulting it in
+        boost::recursive_mutex::scoped_lock lock(load_ref_count_mutex_);
+        if (!isLibraryLoaded()) {
+          loadLibrary();
+        }
+        class_loader::impl::prepareFactoryIndex();
+        if (prefault_pages) {
+          class_loader::impl::prefaultLibrary(getLibraryPath());
+        }
+      }).share();
+  return prefetched_;
 }
 
 int ClassLoader::unloadLibrary()
@@ -116,20 +183,159 @@ int ClassLoader::unloadLibraryInternal(bool lock_plugin_ref_count)
   }
 
   if (plugin_ref_count_ > 0) {
-    CONSOLE_BRIDGE_logWarn("class_loader.ClassLoader: SEVERE WARNING!!!\n"
+    CLASS_LOADER_LOG_WARN("class_loader.ClassLoader: SEVERE WARNING!!!\n"
                            "Attempting to unload %s\n"
                            "while objects created by this library still exist in the heap!\n"
                            "You should delete your objects before destroying the ClassLoader. "
                            "The library will NOT be unloaded.", library_path_.c_str());
-  } else {
-    load_ref_count_ = load_ref_count_ - 1;
-    if (0 == load_ref_count_) {
-      class_loader::impl::unloadLibrary(getLibraryPath(), this);
-    } else if (load_ref_count_ < 0) {
-      load_ref_count_ = 0;
+  } else if (load_ref_count_.load() > 0 && 0 == --load_ref_count_) {
+    // Note: loadLibrary() only counts without locking while the count is above 0, so the
+    // library cannot be reloaded before we are done unloading it.
+    ++library_generation_;
+    purgePooledStorage();
+    class_loader::impl::unloadLibrary(getLibraryPath(), this);
+  }
+  return load_ref_count_.load();
+}
+
+void ClassLoader::acquirePluginReference()
+{
+  int plugin_ref_count = plugin_ref_count_.load();
+  while (plugin_ref_count > 0) {
+    if (plugin_ref_count_.compare_exchange_weak(plugin_ref_count, plugin_ref_count + 1)) {
+      return;
+    }
+  }
+
+  // Possibly the first plugin, this waits for the last one to be done unloading the library
+  boost::recursive_mutex::scoped_lock load_ref_lock(load_ref_count_mutex_);
+  boost::recursive_mutex::scoped_lock plugin_ref_lock(plugin_ref_count_mutex_);
+  // Note: No need to wait, an unload that is already running cannot get hold of the mutexes
+  // before we are done and will then find a plugin
+  class_loader::impl::cancelDeferredUnload(this, false);
+  unload_pending_ = false;
+  if (0 == plugin_ref_count_.load() && !isLibraryLoaded()) {
+    loadLibrary();
+  }
+  ++plugin_ref_count_;
+}
+
+void ClassLoader::releasePluginReference()
+{
+  int plugin_ref_count = plugin_ref_count_.load();
+  while (plugin_ref_count > 1) {
+    if (plugin_ref_count_.compare_exchange_weak(plugin_ref_count, plugin_ref_count - 1)) {
+      return;
+    }
+  }
+
+  // Possibly the last plugin, which may have to unload the library
+  boost::recursive_mutex::scoped_lock load_ref_lock(load_ref_count_mutex_);
+  boost::recursive_mutex::scoped_lock plugin_ref_lock(plugin_ref_count_mutex_);
+  int remaining = --plugin_ref_count_;
+  assert(remaining >= 0);
+  if (0 == remaining && (isOnDemandLoadUnloadEnabled() || retired_)) {
+    if (ClassLoader::hasUnmanagedInstanceBeenCreated()) {
+      CLASS_LOADER_LOG_WARN(
+        "class_loader::ClassLoader: "
+        "Cannot unload library %s even though last shared pointer went out of scope. "
+        "This is because createUnmanagedInstance was used within the scope of this process,"
+        " perhaps by a different ClassLoader. Library will NOT be closed.",
+        getLibraryPath().c_str());
+    } else if (retired_) {
+      unloadRetiredLibrary();
+    } else if (unload_grace_period_ > std::chrono::steady_clock::duration::zero()) {
+      unload_pending_ = true;
+      class_loader::impl::scheduleDeferredUnload(
+        this, std::chrono::steady_clock::now() + unload_grace_period_,
+        [this]() {unloadIdleLibrary();});
+    } else {
+      unloadLibraryInternal(false);
+    }
+  }
+}
+
+void ClassLoader::unloadIdleLibrary()
+{
+  boost::recursive_mutex::scoped_lock load_ref_lock(load_ref_count_mutex_);
+  boost::recursive_mutex::scoped_lock plugin_ref_lock(plugin_ref_count_mutex_);
+  // Note: A plugin created in the meantime cancels the unload, even if destroyed again
+  if (unload_pending_ && 0 == plugin_ref_count_.load()) {
+    unload_pending_ = false;
+    unloadLibraryInternal(false);
+  }
+}
+
+void ClassLoader::retireLibrary()
+{
+  boost::recursive_mutex::scoped_lock load_ref_lock(load_ref_count_mutex_);
+  boost::recursive_mutex::scoped_lock plugin_ref_lock(plugin_ref_count_mutex_);
+  class_loader::impl::cancelDeferredUnload(this, false);
+  unload_pending_ = false;
+  retired_ = true;
+  if (0 == plugin_ref_count_.load()) {
+    unloadRetiredLibrary();
+  }
+}
+
+bool ClassLoader::isLibraryRetired()
+{
+  boost::recursive_mutex::scoped_lock plugin_ref_lock(plugin_ref_count_mutex_);
+  return retired_;
+}
+
+void ClassLoader::unloadRetiredLibrary()
+{
+  while (unloadLibraryInternal(false) > 0) {
+  }
+}
+
+void ClassLoader::setUnloadGracePeriod(std::chrono::steady_clock::duration grace_period)
+{
+  boost::recursive_mutex::scoped_lock lock(plugin_ref_count_mutex_);
+  unload_grace_period_ = grace_period;
+}
+
+std::chrono::steady_clock::duration ClassLoader::getUnloadGracePeriod()
+{
+  boost::recursive_mutex::scoped_lock lock(plugin_ref_count_mutex_);
+  return unload_grace_period_;
+}
+
+void * ClassLoader::allocatePooledStorage(
+  const impl::AbstractMetaObjectBase * factory, size_t size, size_t alignment)
+{
+  {
+    boost::recursive_mutex::scoped_lock lock(pooled_storage_mutex_);
+    std::vector<void *> & pool = pooled_storage_[factory];
+    if (!pool.empty()) {
+      void * storage = pool.back();
+      pool.pop_back();
+      return storage;
+    }
+  }
+  void * storage = boost::alignment::aligned_alloc(alignment, size);
+  if (nullptr == storage) {
+    throw std::bad_alloc();
+  }
+  return storage;
+}
+
+void ClassLoader::releasePooledStorage(const impl::AbstractMetaObjectBase * factory, void * storage)
+{
+  boost::recursive_mutex::scoped_lock lock(pooled_storage_mutex_);
+  pooled_storage_[factory].push_back(storage);
+}
+
+void ClassLoader::purgePooledStorage()
+{
+  boost::recursive_mutex::scoped_lock lock(pooled_storage_mutex_);
+  for (auto & it : pooled_storage_) {
+    for (auto & storage : it.second) {
+      boost::alignment::aligned_free(storage);
     }
   }
-  return load_ref_count_;
+  pooled_storage_.clear();
 }
 
 }  // namespace class_loader
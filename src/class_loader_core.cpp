@@ -30,11 +30,48 @@
 #include "class_loader/class_loader_core.hpp"
 #include "class_loader/class_loader.hpp"
 
-#include <Poco/SharedLibrary.h>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <link.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <set>
+#include <sstream>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace class_loader
@@ -43,6 +80,153 @@ namespace impl
 {
 
 
+// Symbols
+
+const size_t kFirstSymbolChunkSize = 64;
+const size_t kNumSymbolChunks = 32;
+
+/**
+ * @brief The interned names, an ID is the index of its name. Names are never removed and are
+ * stored in chunks that double in size and never move, so that references to them stay valid and
+ * getSymbolName() reads them without the mutex.
+ */
+struct SymbolTable
+{
+  SymbolTable()
+  {
+    for (auto & chunk : chunks_) {
+      chunk.store(nullptr, std::memory_order_relaxed);
+    }
+    addName(std::string());  // kInvalidSymbolId names the empty string
+  }
+
+  /**
+   * @brief Finds the chunk of an ID and the index of its name in it
+   */
+  static void locate(SymbolId id, size_t & chunk, size_t & index)
+  {
+    size_t position = static_cast<size_t>(id) + kFirstSymbolChunkSize;
+    chunk = 0;
+    while ((kFirstSymbolChunkSize << (chunk + 1)) <= position) {
+      ++chunk;
+    }
+    index = position - (kFirstSymbolChunkSize << chunk);
+  }
+
+  /**
+   * @brief Gets the name of an ID, the caller has to know the ID (and thereby its name) exists
+   */
+  const std::string & getName(SymbolId id) const
+  {
+    size_t chunk, index;
+    locate(id, chunk, index);
+    const std::string * names = chunks_[chunk].load(std::memory_order_acquire);
+    assert(nullptr != names);
+    return names[index];
+  }
+
+  /**
+   * @brief Stores the name of the next ID, mutex_ has to be held
+   * @return The ID of the name
+   */
+  SymbolId addName(const std::string & name)
+  {
+    SymbolId id = size_;
+    size_t chunk, index;
+    locate(id, chunk, index);
+    assert(chunk < kNumSymbolChunks);
+    std::string * names = chunks_[chunk].load(std::memory_order_relaxed);
+    if (nullptr == names) {
+      names = new std::string[kFirstSymbolChunkSize << chunk];
+      names[index] = name;
+      chunks_[chunk].store(names, std::memory_order_release);
+    } else {
+      names[index] = name;
+    }
+    ++size_;
+    return id;
+  }
+
+  boost::mutex mutex_;
+  std::unordered_map<std::string, SymbolId> ids_;
+  SymbolId size_ = 0;
+  std::atomic<std::string *> chunks_[kNumSymbolChunks];
+};
+
+SymbolTable & getSymbolTable()
+{
+  // Note: Never destroyed, ClassLoaders with static storage duration may unload after it would be
+  static SymbolTable * instance = new SymbolTable();
+  return *instance;
+}
+
+bool & isSymbolCacheDestroyed()
+{
+  static thread_local bool destroyed = false;
+  return destroyed;
+}
+
+/**
+ * @brief The IDs a thread has looked up. As IDs are never reused, any ID a thread has seen stays
+ * valid for it to cache.
+ */
+struct SymbolCache
+{
+  ~SymbolCache()
+  {
+    isSymbolCacheDestroyed() = true;
+  }
+
+  std::unordered_map<std::string, SymbolId> ids_;
+};
+
+SymbolId lookUpSymbol(const std::string & name, bool intern)
+{
+  static thread_local SymbolCache cache;
+  // Note: The cache of the main thread is destroyed before objects with static storage duration
+  bool is_cached = !isSymbolCacheDestroyed();
+  if (is_cached) {
+    auto cached_itr = cache.ids_.find(name);
+    if (cached_itr != cache.ids_.end()) {
+      return cached_itr->second;
+    }
+  }
+
+  SymbolTable & table = getSymbolTable();
+  SymbolId id = kInvalidSymbolId;
+  {
+    boost::mutex::scoped_lock lock(table.mutex_);
+    auto itr = table.ids_.find(name);
+    if (itr != table.ids_.end()) {
+      id = itr->second;
+    } else if (intern) {
+      id = table.addName(name);
+      table.ids_.insert(std::make_pair(name, id));
+    }
+  }
+  if (is_cached && kInvalidSymbolId != id) {
+    cache.ids_.insert(std::make_pair(name, id));
+  }
+  return id;
+}
+
+SymbolId internSymbol(const std::string & name)
+{
+  return lookUpSymbol(name, true);
+}
+
+SymbolId findSymbol(const std::string & name)
+{
+  return lookUpSymbol(name, false);
+}
+
+const std::string & getSymbolName(SymbolId id)
+{
+  // Note: Lock-free, whoever got the ID got it after its name was stored
+  return getSymbolTable().getName(id);
+}
+
+
 // Global data
 
 boost::recursive_mutex & getLoadedLibraryVectorMutex()
@@ -65,30 +249,224 @@ BaseToFactoryMapMap & getGlobalPluginBaseToFactoryMapMap()
 
 FactoryMap & getFactoryMapForBaseClass(const std::string & typeid_base_class_name)
 {
-  BaseToFactoryMapMap & factoryMapMap = getGlobalPluginBaseToFactoryMapMap();
-  std::string base_class_name = typeid_base_class_name;
-  if (factoryMapMap.find(base_class_name) == factoryMapMap.end()) {
-    factoryMapMap[base_class_name] = FactoryMap();
+  return getFactoryMapForBaseClass(internSymbol(typeid_base_class_name));
+}
+
+FactoryKey makeFactoryKey(SymbolId typeid_base_class_id, SymbolId class_id)
+{
+  return (static_cast<FactoryKey>(typeid_base_class_id) << 32) | class_id;
+}
+
+/**
+ * @brief An immutable, hashed copy of the FactoryMaps of a FactoryShard tagged with the
+ * generation of the shard it was built from, flattened into a single map keyed by
+ * makeFactoryKey().
+ */
+struct FactoryIndex
+{
+  explicit FactoryIndex(size_t generation)
+  : generation_(generation) {}
+
+  size_t generation_;
+  FactoryIndexMap factories_;
+};
+
+/**
+ * @brief A shard of the global Base-to-FactoryMap map, i.e. the FactoryMaps of the base classes
+ * whose IDs hash to it, with its own mutex and generation so that findFactory() only ever
+ * refreshes the snapshot of the shard a factory map was modified in. The FactoryMaps are modified
+ * while holding both getPluginBaseToFactoryMapMapMutex() and mutex_, they may be read while
+ * holding either of them.
+ */
+struct FactoryShard
+{
+  FactoryShard()
+  : generation_(1) {}
+
+  boost::mutex mutex_;
+  std::atomic<size_t> generation_;
+  // Note: Guarded by mutex_, std::map never moves the FactoryMaps pointed to
+  std::vector<std::pair<SymbolId, const FactoryMap *>> factory_maps_;
+  std::shared_ptr<const FactoryIndex> index_;
+};
+
+const size_t kNumFactoryShards = 16;
+
+FactoryShard * getFactoryShards()
+{
+  static FactoryShard shards[kNumFactoryShards];
+  return shards;
+}
+
+size_t getFactoryShardIndex(SymbolId typeid_base_class_id)
+{
+  return typeid_base_class_id % kNumFactoryShards;
+}
+
+FactoryShard & getFactoryShard(SymbolId typeid_base_class_id)
+{
+  return getFactoryShards()[getFactoryShardIndex(typeid_base_class_id)];
+}
+
+FactoryMap & getFactoryMapForBaseClass(SymbolId typeid_base_class_id)
+{
+  BaseToFactoryMapMap & factory_map_map = getGlobalPluginBaseToFactoryMapMap();
+  BaseToFactoryMapMap::iterator itr = factory_map_map.find(typeid_base_class_id);
+  if (itr == factory_map_map.end()) {
+    FactoryShard & shard = getFactoryShard(typeid_base_class_id);
+    boost::mutex::scoped_lock lock(shard.mutex_);
+    itr = factory_map_map.insert(std::make_pair(typeid_base_class_id, FactoryMap())).first;
+    shard.factory_maps_.push_back(std::make_pair(typeid_base_class_id, &itr->second));
+  }
+  return itr->second;
+}
+
+/**
+ * @brief Puts a factory into the FactoryMap of its base class, replacing the one registered under
+ * the same class name, and invalidates the snapshot of its shard. Must be invoked while holding
+ * getPluginBaseToFactoryMapMapMutex().
+ */
+void publishMetaObject(FactoryMap & factory_map, AbstractMetaObjectBase * meta_obj)
+{
+  FactoryShard & shard = getFactoryShard(meta_obj->typeidBaseClassId());
+  boost::mutex::scoped_lock lock(shard.mutex_);
+  factory_map[meta_obj->classId()] = meta_obj;
+  shard.generation_.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * @brief Takes a factory out of the FactoryMap of its base class and invalidates the snapshot of
+ * its shard. Must be invoked while holding getPluginBaseToFactoryMapMapMutex().
+ */
+void unpublishMetaObject(AbstractMetaObjectBase * meta_obj)
+{
+  FactoryMap & factory_map = getFactoryMapForBaseClass(meta_obj->typeidBaseClassId());
+  FactoryShard & shard = getFactoryShard(meta_obj->typeidBaseClassId());
+  boost::mutex::scoped_lock lock(shard.mutex_);
+  factory_map.erase(meta_obj->classId());
+  shard.generation_.fetch_add(1, std::memory_order_release);
+}
+
+void invalidateFactoryIndex()
+{
+  for (size_t i = 0; i < kNumFactoryShards; ++i) {
+    FactoryShard & shard = getFactoryShards()[i];
+    boost::mutex::scoped_lock lock(shard.mutex_);
+    shard.generation_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+std::shared_ptr<const FactoryIndex> refreshFactoryIndex(FactoryShard & shard)
+{
+  boost::mutex::scoped_lock lock(shard.mutex_);
+  size_t generation = shard.generation_.load(std::memory_order_acquire);
+  if (!shard.index_ || shard.index_->generation_ != generation) {
+    std::shared_ptr<FactoryIndex> index = std::make_shared<FactoryIndex>(generation);
+    for (auto & base_it : shard.factory_maps_) {
+      for (auto & it : *base_it.second) {
+        index->factories_[makeFactoryKey(base_it.first, it.first)] = it.second;
+      }
+    }
+    shard.index_ = index;
+  }
+  return shard.index_;
+}
+
+void prepareFactoryIndex()
+{
+  for (size_t i = 0; i < kNumFactoryShards; ++i) {
+    refreshFactoryIndex(getFactoryShards()[i]);
+  }
+}
+
+AbstractMetaObjectBase * findFactory(
+  const std::string & typeid_base_class_name, const std::string & class_name)
+{
+  SymbolId typeid_base_class_id = findSymbol(typeid_base_class_name);
+  SymbolId class_id = findSymbol(class_name);
+  if (kInvalidSymbolId == typeid_base_class_id || kInvalidSymbolId == class_id) {
+    return nullptr;
+  }
+  return findFactory(typeid_base_class_id, class_id);
+}
+
+AbstractMetaObjectBase * findFactory(SymbolId typeid_base_class_id, SymbolId class_id)
+{
+  // Every thread keeps a reference to the last snapshot of each shard it has used, so the steady
+  // state lookup is a single atomic load plus one hash probe of an integer key. Outdated snapshots
+  // are released once the last thread referencing them has refreshed.
+  static thread_local std::shared_ptr<const FactoryIndex> cached_indexes[kNumFactoryShards];
+  size_t shard_index = getFactoryShardIndex(typeid_base_class_id);
+  FactoryShard & shard = getFactoryShards()[shard_index];
+  std::shared_ptr<const FactoryIndex> & cached_index = cached_indexes[shard_index];
+  if (!cached_index ||
+    cached_index->generation_ != shard.generation_.load(std::memory_order_acquire))
+  {
+    cached_index = refreshFactoryIndex(shard);
+  }
+
+  FactoryIndexMap::const_iterator factory_itr =
+    cached_index->factories_.find(makeFactoryKey(typeid_base_class_id, class_id));
+  if (factory_itr == cached_index->factories_.end()) {
+    return nullptr;
+  }
+  return factory_itr->second;
+}
+
+boost::recursive_mutex & getLibraryMutex(const std::string & library_path)
+{
+  static boost::mutex library_mutexes_mutex;
+  static std::unordered_map<LibraryPath, std::unique_ptr<boost::recursive_mutex>> library_mutexes;
+  boost::mutex::scoped_lock lock(library_mutexes_mutex);
+  std::unique_ptr<boost::recursive_mutex> & library_mutex = library_mutexes[library_path];
+  if (nullptr == library_mutex) {
+    library_mutex.reset(new boost::recursive_mutex());
   }
+  return *library_mutex;
+}
+
+/**
+ * @brief The graveyard, i.e. the metaobjects taken out of the global Base-to-FactoryMap map as
+ * their library was unloaded (@see destroyMetaObjectsForLibrary()), by library ID so that the
+ * metaobjects of a reloaded library can be revived or purged without scanning those of others.
+ * Guarded by getPluginBaseToFactoryMapMapMutex().
+ */
+typedef std::unordered_map<SymbolId, MetaObjectVector> MetaObjectGraveyard;
 
-  return factoryMapMap[base_class_name];
+MetaObjectGraveyard & getMetaObjectGraveyard()
+{
+  static MetaObjectGraveyard instance;
+  return instance;
 }
 
-MetaObjectVector & getMetaObjectGraveyard()
+/**
+ * @brief Index of the metaobjects currently held by the global Base-to-FactoryMap map, by
+ * library ID, and of how many of each library's metaobjects every ClassLoader owns.
+ * Guarded by getPluginBaseToFactoryMapMapMutex().
+ */
+struct MetaObjectIndex
+{
+  std::unordered_map<SymbolId, MetaObjectVector> meta_objects_by_library_;
+  std::unordered_map<const ClassLoader *, std::map<SymbolId, size_t>> owned_counts_by_loader_;
+};
+
+MetaObjectIndex & getMetaObjectIndex()
 {
-  static MetaObjectVector instance;
+  static MetaObjectIndex instance;
   return instance;
 }
 
-LibraryVector & getLoadedLibraryVector()
+LibraryMap & getLoadedLibraryMap()
 {
-  static LibraryVector instance;
+  static LibraryMap instance;
   return instance;
 }
 
 std::string & getCurrentlyLoadingLibraryNameReference()
 {
-  static std::string library_name;
+  // Note: Plugins register from within dlopen() on the loading thread, so every thread keeps its
+  // own loading state and libraries can be loaded by several threads at the same time.
+  static thread_local std::string library_name;
   return library_name;
 }
 
@@ -105,7 +483,7 @@ void setCurrentlyLoadingLibraryName(const std::string & library_name)
 
 ClassLoader * & getCurrentlyActiveClassLoaderReference()
 {
-  static ClassLoader * loader = nullptr;
+  static thread_local ClassLoader * loader = nullptr;
   return loader;
 }
 
@@ -120,211 +498,1452 @@ void setCurrentlyActiveClassLoader(ClassLoader * loader)
   loader_ref = loader;
 }
 
-bool & hasANonPurePluginLibraryBeenOpenedReference()
+ScopedLoadingContext::ScopedLoadingContext(
+  const std::string & library_path, ClassLoader * loader)
+: previous_library_name_(getCurrentlyLoadingLibraryName()),
+  previous_loader_(getCurrentlyActiveClassLoader())
+{
+  setCurrentlyLoadingLibraryName(library_path);
+  setCurrentlyActiveClassLoader(loader);
+}
+
+ScopedLoadingContext::~ScopedLoadingContext()
+{
+  setCurrentlyLoadingLibraryName(previous_library_name_);
+  setCurrentlyActiveClassLoader(previous_loader_);
+}
+
+bool & hasANonPurePluginLibraryBeenOpenedReference()
+{
+  static bool hasANonPurePluginLibraryBeenOpenedReference = false;
+  return hasANonPurePluginLibraryBeenOpenedReference;
+}
+
+bool hasANonPurePluginLibraryBeenOpened()
+{
+  return hasANonPurePluginLibraryBeenOpenedReference();
+}
+
+void hasANonPurePluginLibraryBeenOpened(bool hasIt)
+{
+  hasANonPurePluginLibraryBeenOpenedReference() = hasIt;
+}
+
+void logNonPurePluginLibraryAlert()
+{
+  CLASS_LOADER_LOG_DEBUG("%s",
+    "class_loader.impl: ALERT!!! "
+    "A library containing plugins has been opened through a means other than through the "
+    "class_loader or pluginlib package. "
+    "This can happen if you build plugin libraries that contain more than just plugins "
+    "(i.e. normal code your app links against). "
+    "This inherently will trigger a dlopen() prior to main() and cause problems as class_loader "
+    "is not aware of plugin factories that autoregister under the hood. "
+    "The class_loader package can compensate, but you may run into namespace collision problems "
+    "(e.g. if you have the same plugin class in two different libraries and you load them both "
+    "at the same time). "
+    "The biggest problem is that library can now no longer be safely unloaded as the "
+    "ClassLoader does not know when non-plugin code is still in use. "
+    "In fact, no ClassLoader instance in your application will be unable to unload any library "
+    "once a non-pure one has been opened. "
+    "Please refactor your code to isolate plugins into their own libraries.");
+}
+
+void logNamespaceCollisionWarning(const std::string & class_name)
+{
+  CLASS_LOADER_LOG_WARN(
+    "class_loader.impl: SEVERE WARNING!!! "
+    "A namespace collision has occured with plugin factory for class %s. "
+    "New factory will OVERWRITE existing one. "
+    "This situation occurs when libraries containing plugins are directly linked against an "
+    "executable (the one running right now generating this message). "
+    "Please separate plugins out into their own library or just don't link against the library "
+    "and use either class_loader::ClassLoader/MultiLibraryClassLoader to open.",
+    class_name.c_str());
+}
+
+void logUnownedFactoryAlert()
+{
+  CLASS_LOADER_LOG_DEBUG("%s",
+    "class_loader.impl: ALERT!!! "
+    "A metaobject (i.e. factory) exists for desired class, but has no owner. "
+    "This implies that the library containing the class was dlopen()ed by means other than "
+    "through the class_loader interface. "
+    "This can happen if you build plugin libraries that contain more than just plugins "
+    "(i.e. normal code your app links against) -- that intrinsically will trigger a dlopen() "
+    "prior to main(). "
+    "You should isolate your plugins into their own library, otherwise it will not be "
+    "possible to shutdown the library!");
+}
+
+/**
+ * @brief The IDs handed out by allocateClassLoaderId() which are free again, and the lowest ID
+ * that was never handed out.
+ */
+struct ClassLoaderIds
+{
+  ClassLoaderIds()
+  : next_id_(1) {}
+
+  boost::mutex mutex_;
+  std::set<size_t> free_ids_;
+  size_t next_id_;
+};
+
+ClassLoaderIds & getClassLoaderIds()
+{
+  static ClassLoaderIds instance;
+  return instance;
+}
+
+size_t allocateClassLoaderId()
+{
+  ClassLoaderIds & ids = getClassLoaderIds();
+  boost::mutex::scoped_lock lock(ids.mutex_);
+  if (ids.free_ids_.empty()) {
+    return ids.next_id_++;
+  }
+  size_t id = *ids.free_ids_.begin();
+  ids.free_ids_.erase(ids.free_ids_.begin());
+  return id;
+}
+
+void freeClassLoaderId(size_t id)
+{
+  ClassLoaderIds & ids = getClassLoaderIds();
+  boost::mutex::scoped_lock lock(ids.mutex_);
+  ids.free_ids_.insert(id);
+}
+
+
+// Deferred unloads
+
+/**
+ * @brief The unloads scheduled by ClassLoaders, run by a thread of its own which is started with
+ * the first unload. Leaked as ClassLoaders with static storage duration may cancel their unloads
+ * while the process exits, after the thread was stopped (@see stopUnloadReaper()).
+ */
+struct UnloadReaper
+{
+  struct Unload
+  {
+    std::chrono::steady_clock::time_point deadline_;
+    std::function<void()> function_;
+  };
+
+  UnloadReaper()
+  : running_(nullptr), started_(false), stopped_(false) {}
+
+  boost::mutex mutex_;
+  boost::condition_variable condition_;
+  std::unordered_map<const ClassLoader *, Unload> unloads_;
+  // The ClassLoader whose unload is being run
+  const ClassLoader * running_;
+  boost::thread thread_;
+  bool started_;
+  bool stopped_;
+};
+
+UnloadReaper & getUnloadReaper()
+{
+  static UnloadReaper * instance = new UnloadReaper();
+  return *instance;
+}
+
+void runUnloadReaper()
+{
+  UnloadReaper & reaper = getUnloadReaper();
+  boost::mutex::scoped_lock lock(reaper.mutex_);
+  while (!reaper.stopped_) {
+    auto next = reaper.unloads_.end();
+    for (auto itr = reaper.unloads_.begin(); itr != reaper.unloads_.end(); ++itr) {
+      if (next == reaper.unloads_.end() || itr->second.deadline_ < next->second.deadline_) {
+        next = itr;
+      }
+    }
+    if (next == reaper.unloads_.end()) {
+      reaper.condition_.wait(lock);
+      continue;
+    }
+    if (std::chrono::steady_clock::now() < next->second.deadline_) {
+      // Note: boost::condition_variable does not take std::chrono time points
+      auto timeout = std::chrono::duration_cast<std::chrono::microseconds>(
+        next->second.deadline_ - std::chrono::steady_clock::now());
+      reaper.condition_.timed_wait(lock, boost::posix_time::microseconds(timeout.count() + 1));
+      continue;
+    }
+
+    std::function<void()> function;
+    function.swap(next->second.function_);
+    reaper.running_ = next->first;
+    reaper.unloads_.erase(next);
+    lock.unlock();
+    try {
+      function();
+    } catch (const class_loader::ClassLoaderException & e) {
+      CLASS_LOADER_LOG_ERROR(
+        "class_loader.impl: Deferred unload failed (%s)", e.what());
+    }
+    lock.lock();
+    reaper.running_ = nullptr;
+    reaper.condition_.notify_all();
+  }
+}
+
+void stopUnloadReaper()
+{
+  UnloadReaper & reaper = getUnloadReaper();
+  {
+    boost::mutex::scoped_lock lock(reaper.mutex_);
+    reaper.stopped_ = true;
+    reaper.condition_.notify_all();
+  }
+  reaper.thread_.join();
+}
+
+void scheduleDeferredUnload(
+  const ClassLoader * loader, std::chrono::steady_clock::time_point deadline,
+  std::function<void()> unload)
+{
+  UnloadReaper & reaper = getUnloadReaper();
+  boost::mutex::scoped_lock lock(reaper.mutex_);
+  if (reaper.stopped_) {
+    // The process is exiting, the library is unloaded when its ClassLoader is destroyed
+    return;
+  }
+  if (!reaper.started_) {
+    reaper.started_ = true;
+    reaper.thread_ = boost::thread(runUnloadReaper);
+    // Note: Registered after the construction of any static ClassLoader that made it here, so
+    // the thread is stopped before those are destroyed
+    std::atexit(stopUnloadReaper);
+  }
+  UnloadReaper::Unload & scheduled = reaper.unloads_[loader];
+  scheduled.deadline_ = deadline;
+  scheduled.function_ = std::move(unload);
+  reaper.condition_.notify_all();
+}
+
+void cancelDeferredUnload(const ClassLoader * loader, bool wait)
+{
+  UnloadReaper & reaper = getUnloadReaper();
+  boost::mutex::scoped_lock lock(reaper.mutex_);
+  reaper.unloads_.erase(loader);
+  while (wait && reaper.running_ == loader) {
+    reaper.condition_.wait(lock);
+  }
+}
+
+
+// Concurrency
+
+void runConcurrently(
+  size_t num_tasks, size_t num_threads, const std::function<void(size_t)> & task)
+{
+  std::vector<std::exception_ptr> errors(num_tasks);
+  std::atomic<size_t> next_task(0);
+  auto run_pending_tasks = [&]() {
+      for (size_t i = next_task++; i < num_tasks; i = next_task++) {
+        try {
+          task(i);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      }
+    };
+
+  std::vector<boost::thread> workers;
+  for (size_t i = 1; i < std::min(num_threads, num_tasks); ++i) {
+    workers.emplace_back(run_pending_tasks);
+  }
+  run_pending_tasks();
+  for (auto & worker : workers) {
+    worker.join();
+  }
+  for (auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+
+// Statistics
+
+/**
+ * @brief The load statistics of every library loaded so far, by library ID
+ */
+struct LibraryStatisticsTable
+{
+  boost::mutex mutex_;
+  std::unordered_map<SymbolId, LibraryStatistics> libraries_;
+  // The counts of the classes whose factories were destroyed, as a reloaded library registered
+  // new ones, by library, base class and class ID
+  std::map<std::tuple<SymbolId, SymbolId, SymbolId>, ClassStatistics> retired_classes_;
+};
+
+std::tuple<SymbolId, SymbolId, SymbolId> makeClassStatisticsKey(
+  const AbstractMetaObjectBase * meta_obj)
+{
+  return std::make_tuple(
+    meta_obj->associatedLibraryId(), meta_obj->typeidBaseClassId(), meta_obj->classId());
+}
+
+LibraryStatisticsTable & getLibraryStatisticsTable()
+{
+  static LibraryStatisticsTable instance;
+  return instance;
+}
+
+uint64_t & getRegistrationTimeReference()
+{
+  // Note: Total time the calling thread spent in registerPlugin(), loadLibrary() attributes the
+  // time spent while opening a library to it
+  static thread_local uint64_t registration_time_ns = 0;
+  return registration_time_ns;
+}
+
+uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename Update>
+void updateLibraryStatistics(const std::string & library_path, Update update)
+{
+#ifndef CLASS_LOADER_DISABLE_STATISTICS
+  LibraryStatisticsTable & table = getLibraryStatisticsTable();
+  boost::mutex::scoped_lock lock(table.mutex_);
+  auto itr = table.libraries_.find(internSymbol(library_path));
+  if (itr == table.libraries_.end()) {
+    LibraryStatistics stats = {library_path, 0, 0, 0, 0, 0, 0};
+    itr = table.libraries_.insert(std::make_pair(internSymbol(library_path), stats)).first;
+  }
+  update(itr->second);
+#else
+  (void)library_path;
+  (void)update;
+#endif
+}
+
+/**
+ * @brief Keeps the counts of a factory about to be destroyed in the statistics table, so that
+ * they add to those of the factory of the same class that replaces it
+ */
+void retireClassStatistics(const AbstractMetaObjectBase * meta_obj)
+{
+#ifndef CLASS_LOADER_DISABLE_STATISTICS
+  LibraryStatisticsTable & table = getLibraryStatisticsTable();
+  boost::mutex::scoped_lock lock(table.mutex_);
+  auto itr = table.retired_classes_.find(makeClassStatisticsKey(meta_obj));
+  if (itr == table.retired_classes_.end()) {
+    ClassStatistics stats = {
+      meta_obj->className(), meta_obj->baseClassName(), meta_obj->getAssociatedLibraryPath(), 0, 0
+    };
+    itr = table.retired_classes_.insert(std::make_pair(makeClassStatisticsKey(meta_obj), stats))
+      .first;
+  }
+  itr->second.creation_count += meta_obj->getCreationCount();
+  itr->second.destruction_count += meta_obj->getDestructionCount();
+#else
+  static_cast<void>(meta_obj);
+#endif
+}
+
+ScopedRegistrationTimer::ScopedRegistrationTimer()
+: start_(std::chrono::steady_clock::now())
+{
+}
+
+ScopedRegistrationTimer::~ScopedRegistrationTimer()
+{
+  getRegistrationTimeReference() += elapsedNanoseconds(start_);
+}
+
+bool & getStagingRegistrationsReference()
+{
+  static thread_local bool staging = false;
+  return staging;
+}
+
+bool isStagingRegistrations()
+{
+  return getStagingRegistrationsReference();
+}
+
+ScopedStagedRegistration::ScopedStagedRegistration()
+: previous_staging_(getStagingRegistrationsReference())
+{
+  getStagingRegistrationsReference() = true;
+}
+
+ScopedStagedRegistration::~ScopedStagedRegistration()
+{
+  getStagingRegistrationsReference() = previous_staging_;
+}
+
+MetaObjectVector allMetaObjects();
+
+Statistics getStatistics()
+{
+  Statistics statistics;
+  {
+    LibraryStatisticsTable & table = getLibraryStatisticsTable();
+    boost::mutex::scoped_lock lock(table.mutex_);
+    for (auto & it : table.libraries_) {
+      statistics.libraries.push_back(it.second);
+    }
+  }
+  std::sort(statistics.libraries.begin(), statistics.libraries.end(),
+    [](const LibraryStatistics & lhs, const LibraryStatistics & rhs) {
+      return lhs.library_path < rhs.library_path;
+    });
+
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  // Note: A metaobject is either in the global factory map map or in the graveyard, never in both
+  MetaObjectVector meta_objs = allMetaObjects();
+  for (auto & it : getMetaObjectGraveyard()) {
+    meta_objs.insert(meta_objs.end(), it.second.begin(), it.second.end());
+  }
+  std::map<std::tuple<SymbolId, SymbolId, SymbolId>, ClassStatistics> classes;
+  {
+    LibraryStatisticsTable & table = getLibraryStatisticsTable();
+    boost::mutex::scoped_lock table_lock(table.mutex_);
+    classes = table.retired_classes_;
+  }
+  for (auto & meta_obj : meta_objs) {
+    auto itr = classes.find(makeClassStatisticsKey(meta_obj));
+    if (itr == classes.end()) {
+      ClassStatistics stats = {
+        meta_obj->className(), meta_obj->baseClassName(), meta_obj->getAssociatedLibraryPath(),
+        0, 0
+      };
+      itr = classes.insert(std::make_pair(makeClassStatisticsKey(meta_obj), stats)).first;
+    }
+    itr->second.creation_count += meta_obj->getCreationCount();
+    itr->second.destruction_count += meta_obj->getDestructionCount();
+  }
+  for (auto & it : classes) {
+    statistics.classes.push_back(it.second);
+  }
+  std::sort(statistics.classes.begin(), statistics.classes.end(),
+    [](const ClassStatistics & lhs, const ClassStatistics & rhs) {
+      if (lhs.library_path != rhs.library_path) {
+        return lhs.library_path < rhs.library_path;
+      }
+      return lhs.class_name < rhs.class_name;
+    });
+  return statistics;
+}
+
+void resetStatistics()
+{
+  {
+    LibraryStatisticsTable & table = getLibraryStatisticsTable();
+    boost::mutex::scoped_lock lock(table.mutex_);
+    table.libraries_.clear();
+    table.retired_classes_.clear();
+  }
+
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  for (auto & meta_obj : allMetaObjects()) {
+    meta_obj->resetCounts();
+  }
+  for (auto & it : getMetaObjectGraveyard()) {
+    for (auto & meta_obj : it.second) {
+      meta_obj->resetCounts();
+    }
+  }
+}
+
+
+// MetaObject search/insert/removal/query
+
+MetaObjectVector allMetaObjects(const FactoryMap & factories)
+{
+  MetaObjectVector all_meta_objs;
+  for (auto & it : factories) {
+    all_meta_objs.push_back(it.second);
+  }
+  return all_meta_objs;
+}
+
+MetaObjectVector allMetaObjects()
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+
+  MetaObjectVector all_meta_objs;
+  BaseToFactoryMapMap & factory_map_map = getGlobalPluginBaseToFactoryMapMap();
+  BaseToFactoryMapMap::iterator itr;
+
+  for (auto & it : factory_map_map) {
+    MetaObjectVector objs = allMetaObjects(it.second);
+    all_meta_objs.insert(all_meta_objs.end(), objs.begin(), objs.end());
+  }
+  return all_meta_objs;
+}
+
+void countMetaObjectOwner(SymbolId library_id, const ClassLoader * owner)
+{
+  ++getMetaObjectIndex().owned_counts_by_loader_[owner][library_id];
+}
+
+void uncountMetaObjectOwner(SymbolId library_id, const ClassLoader * owner)
+{
+  auto & owned_counts_by_loader = getMetaObjectIndex().owned_counts_by_loader_;
+  auto loader_itr = owned_counts_by_loader.find(owner);
+  assert(loader_itr != owned_counts_by_loader.end());
+  auto count_itr = loader_itr->second.find(library_id);
+  assert(count_itr != loader_itr->second.end());
+  if (0 == --count_itr->second) {
+    loader_itr->second.erase(count_itr);
+    if (loader_itr->second.empty()) {
+      owned_counts_by_loader.erase(loader_itr);
+    }
+  }
+}
+
+void indexMetaObject(AbstractMetaObjectBase * meta_obj)
+{
+  SymbolId library_id = meta_obj->associatedLibraryId();
+  getMetaObjectIndex().meta_objects_by_library_[library_id].push_back(meta_obj);
+  for (auto & owner : meta_obj->getAssociatedClassLoaders()) {
+    countMetaObjectOwner(library_id, owner);
+  }
+}
+
+void unindexMetaObject(AbstractMetaObjectBase * meta_obj)
+{
+  SymbolId library_id = meta_obj->associatedLibraryId();
+  auto & meta_objects_by_library = getMetaObjectIndex().meta_objects_by_library_;
+  auto library_itr = meta_objects_by_library.find(library_id);
+  assert(library_itr != meta_objects_by_library.end());
+  MetaObjectVector & meta_objs = library_itr->second;
+  meta_objs.erase(std::find(meta_objs.begin(), meta_objs.end(), meta_obj));
+  if (meta_objs.empty()) {
+    meta_objects_by_library.erase(library_itr);
+  }
+  for (auto & owner : meta_obj->getAssociatedClassLoaders()) {
+    uncountMetaObjectOwner(library_id, owner);
+  }
+}
+
+void insertMetaObjectIntoFactoryMap(FactoryMap & factory_map, AbstractMetaObjectBase * meta_obj)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  if (isStagingRegistrations()) {
+    // Note: Found through the index, publishLibraryFactories() puts it into the factory map
+    indexMetaObject(meta_obj);
+    return;
+  }
+  FactoryMap::iterator itr = factory_map.find(meta_obj->classId());
+  if (itr != factory_map.end()) {
+    if (itr->second == meta_obj) {
+      return;
+    }
+    unindexMetaObject(itr->second);
+  }
+  publishMetaObject(factory_map, meta_obj);
+  indexMetaObject(meta_obj);
+}
+
+void addMetaObjectOwner(AbstractMetaObjectBase * meta_obj, ClassLoader * loader)
+{
+  if (!meta_obj->isOwnedBy(loader)) {
+    meta_obj->addOwningClassLoader(loader);
+    countMetaObjectOwner(meta_obj->associatedLibraryId(), loader);
+  }
+}
+
+void removeMetaObjectOwner(AbstractMetaObjectBase * meta_obj, const ClassLoader * loader)
+{
+  if (meta_obj->isOwnedBy(loader)) {
+    meta_obj->removeOwningClassLoader(loader);
+    uncountMetaObjectOwner(meta_obj->associatedLibraryId(), loader);
+  }
+}
+
+MetaObjectVector
+allMetaObjectsForLibrary(const std::string & library_path)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  auto & meta_objects_by_library = getMetaObjectIndex().meta_objects_by_library_;
+  auto itr = meta_objects_by_library.find(findSymbol(library_path));
+  if (itr == meta_objects_by_library.end()) {
+    return MetaObjectVector();
+  }
+  return itr->second;
+}
+
+size_t numMetaObjectsForLibrary(const std::string & library_path)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  auto & meta_objects_by_library = getMetaObjectIndex().meta_objects_by_library_;
+  auto itr = meta_objects_by_library.find(findSymbol(library_path));
+  return itr == meta_objects_by_library.end() ? 0 : itr->second.size();
+}
+
+size_t numMetaObjectsForLibraryOwnedBy(const std::string & library_path, const ClassLoader * owner)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  auto & owned_counts_by_loader = getMetaObjectIndex().owned_counts_by_loader_;
+  auto loader_itr = owned_counts_by_loader.find(owner);
+  if (loader_itr == owned_counts_by_loader.end()) {
+    return 0;
+  }
+  auto count_itr = loader_itr->second.find(findSymbol(library_path));
+  return count_itr == loader_itr->second.end() ? 0 : count_itr->second;
+}
+
+void insertMetaObjectIntoGraveyard(AbstractMetaObjectBase * meta_obj)
+{
+  CLASS_LOADER_LOG_DEBUG(
+    "class_loader.impl: "
+    "Inserting MetaObject (class = %s, base_class = %s, ptr = %p) into graveyard",
+    meta_obj->className().c_str(), meta_obj->baseClassName().c_str(),
+    reinterpret_cast<void *>(meta_obj));
+  getMetaObjectGraveyard()[meta_obj->associatedLibraryId()].push_back(meta_obj);
+}
+
+bool isMetaObjectInFactoryMap(AbstractMetaObjectBase * meta_obj)
+{
+  FactoryMap & factory_map = getFactoryMapForBaseClass(meta_obj->typeidBaseClassId());
+  FactoryMap::iterator itr = factory_map.find(meta_obj->classId());
+  return itr != factory_map.end() && itr->second == meta_obj;
+}
+
+void destroyMetaObjectsForLibrary(const std::string & library_path, const ClassLoader * loader)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+
+  CLASS_LOADER_LOG_DEBUG(
+    "class_loader.impl: "
+    "Removing MetaObjects associated with library %s and class loader %p from global "
+    "plugin-to-factorymap map.\n",
+    library_path.c_str(), reinterpret_cast<const void *>(loader));
+
+  for (auto & meta_obj : allMetaObjectsForLibrary(library_path)) {
+    if (!meta_obj->isOwnedBy(loader)) {
+      continue;
+    }
+    removeMetaObjectOwner(meta_obj, loader);
+    if (!meta_obj->isOwnedByAnybody()) {
+      // Note: The factory may have been replaced by the one of a reloaded build in the meantime
+      if (isMetaObjectInFactoryMap(meta_obj)) {
+        unpublishMetaObject(meta_obj);
+      }
+      unindexMetaObject(meta_obj);
+
+      // Insert into graveyard
+      // We remove the metaobject from its factory map, but we don't destroy it...instead it
+      // saved to a "graveyard" to the side.
+      // This is due to our static global variable initialization problem that causes factories
+      // to not be registered when a library is closed and then reopened.
+      // This is because it's truly not closed due to the use of global symbol binding i.e.
+      // calling dlopen with RTLD_GLOBAL instead of RTLD_LOCAL.
+      // We require using the former as the which is required to support RTTI
+      insertMetaObjectIntoGraveyard(meta_obj);
+    }
+  }
+
+  CLASS_LOADER_LOG_DEBUG("%s", "class_loader.impl: Metaobjects removed.");
+}
+
+bool areThereAnyExistingMetaObjectsForLibrary(const std::string & library_path)
+{
+  return numMetaObjectsForLibrary(library_path) > 0;
+}
+
+// Loaded Library Map manipulation
+LibraryMap::iterator findLoadedLibrary(const std::string & library_path)
+{
+  LibraryMap & open_libraries = getLoadedLibraryMap();
+  SymbolId library_id = findSymbol(library_path);
+  if (kInvalidSymbolId == library_id) {
+    return open_libraries.end();
+  }
+  return open_libraries.find(library_id);
+}
+
+bool isLibraryLoadedByAnybody(const std::string & library_path)
+{
+  boost::recursive_mutex::scoped_lock lock(getLoadedLibraryVectorMutex());
+  return findLoadedLibrary(library_path) != getLoadedLibraryMap().end();
+}
+
+#ifdef __linux__
+/**
+ * @brief The loaded object to fault in (@see prefaultLibrary()), by load address, and the number
+ * of pages touched
+ */
+struct PrefaultedObject
+{
+  ElfW(Addr) address;
+  size_t num_pages;
+};
+
+// Note: Touching pages also reads the redzones AddressSanitizer puts around globals
+__attribute__((no_sanitize_address))
+int prefaultObject(struct dl_phdr_info * info, size_t, void * data)
+{
+  PrefaultedObject * object = static_cast<PrefaultedObject *>(data);
+  if (info->dlpi_addr != object->address) {
+    return 0;
+  }
+  const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr) & segment = info->dlpi_phdr[i];
+    if (PT_LOAD != segment.p_type || 0 == (segment.p_flags & PF_R)) {
+      continue;
+    }
+    uintptr_t begin = (info->dlpi_addr + segment.p_vaddr) & ~(page_size - 1);
+    uintptr_t end = info->dlpi_addr + segment.p_vaddr + segment.p_memsz;
+    madvise(reinterpret_cast<void *>(begin), end - begin, MADV_WILLNEED);
+    for (uintptr_t page = begin; page < end; page += page_size) {
+      static_cast<void>(*reinterpret_cast<const volatile char *>(page));
+      ++object->num_pages;
+    }
+  }
+  return 1;
+}
+#endif
+
+size_t prefaultLibrary(const std::string & library_path)
+{
+#ifdef __linux__
+  if (!isLibraryLoadedByAnybody(library_path)) {
+    return 0;
+  }
+  // Note: The handle also keeps the library mapped while its pages are touched
+  void * handle = dlopen(library_path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+  if (nullptr == handle) {
+    return 0;
+  }
+  PrefaultedObject object = {0, 0};
+  struct link_map * link_map = nullptr;
+  if (0 == dlinfo(handle, RTLD_DI_LINKMAP, &link_map) && nullptr != link_map) {
+    object.address = link_map->l_addr;
+    dl_iterate_phdr(prefaultObject, &object);
+  }
+  dlclose(handle);
+  CLASS_LOADER_LOG_DEBUG(
+    "class_loader.impl: Faulted in %zu pages of library %s.",
+    object.num_pages, library_path.c_str());
+  return object.num_pages;
+#else
+  static_cast<void>(library_path);
+  return 0;
+#endif
+}
+
+bool isLibraryLoaded(const std::string & library_path, ClassLoader * loader)
+{
+  if (!isLibraryLoadedByAnybody(library_path)) {
+    return false;
+  }
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  size_t num_meta_objs_for_lib = numMetaObjectsForLibrary(library_path);
+  return 0 == num_meta_objs_for_lib ||
+         numMetaObjectsForLibraryOwnedBy(library_path, loader) == num_meta_objs_for_lib;
+}
+
+std::vector<std::string> getAllLibrariesUsedByClassLoader(const ClassLoader * loader)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  std::vector<std::string> all_libs;
+  auto & owned_counts_by_loader = getMetaObjectIndex().owned_counts_by_loader_;
+  auto loader_itr = owned_counts_by_loader.find(loader);
+  if (loader_itr != owned_counts_by_loader.end()) {
+    for (auto & it : loader_itr->second) {
+      all_libs.push_back(getSymbolName(it.first));
+    }
+  }
+  return all_libs;
+}
+
+/**
+ * @brief Invokes a callback with every indexed factory of a base class that a ClassLoader owns,
+ * must be invoked while holding getPluginBaseToFactoryMapMapMutex()
+ */
+template<typename Callback>
+void forEachIndexedFactoryOwnedBy(
+  const ClassLoader * owner, SymbolId typeid_base_class_id, Callback && callback)
+{
+  MetaObjectIndex & index = getMetaObjectIndex();
+  auto loader_itr = index.owned_counts_by_loader_.find(owner);
+  if (loader_itr == index.owned_counts_by_loader_.end()) {
+    return;
+  }
+  for (auto & library_it : loader_itr->second) {
+    auto library_itr = index.meta_objects_by_library_.find(library_it.first);
+    if (library_itr == index.meta_objects_by_library_.end()) {
+      continue;
+    }
+    for (auto & meta_obj : library_itr->second) {
+      if (meta_obj->typeidBaseClassId() == typeid_base_class_id && meta_obj->isOwnedBy(owner)) {
+        callback(meta_obj);
+      }
+    }
+  }
+}
+
+void forEachAvailableFactory(
+  const ClassLoader * loader, SymbolId typeid_base_class_id,
+  const std::function<void(AbstractMetaObjectBase *)> & callback)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  forEachIndexedFactoryOwnedBy(loader, typeid_base_class_id, callback);
+  if (nullptr == loader) {
+    return;
+  }
+  // Note: Factories not associated with a ClassLoader are counted as owned by nullptr
+  forEachIndexedFactoryOwnedBy(
+    nullptr, typeid_base_class_id, [loader, &callback](AbstractMetaObjectBase * meta_obj) {
+      if (!meta_obj->isOwnedBy(loader)) {
+        callback(meta_obj);
+      }
+    });
+}
+
+std::vector<std::pair<SymbolId, SymbolId>>
+getRegisteredClassesForLibrary(const std::string & library_path, const ClassLoader * loader)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  std::vector<std::pair<SymbolId, SymbolId>> classes;
+  for (auto & meta_obj : allMetaObjectsForLibrary(library_path)) {
+    if (meta_obj->isOwnedBy(loader)) {
+      classes.push_back(std::make_pair(meta_obj->typeidBaseClassId(), meta_obj->classId()));
+    }
+  }
+  return classes;
+}
+
+
+// Manifests
+
+/**
+ * @brief The (base class, class) pairs listed by a library manifest, base classes spelled as in
+ * the registration macro.
+ */
+typedef std::vector<std::pair<std::string, ClassName>> LibraryManifest;
+
+boost::recursive_mutex & getLibraryManifestMutex()
+{
+  static boost::recursive_mutex m;
+  return m;
+}
+
+std::unordered_map<LibraryPath, std::shared_ptr<const LibraryManifest>> & getLibraryManifests()
+{
+  // Note: A null manifest records that the library has none
+  static std::unordered_map<LibraryPath, std::shared_ptr<const LibraryManifest>> instance;
+  return instance;
+}
+
+bool fileExists(const std::string & path)
+{
+  return std::ifstream(path.c_str()).good();
+}
+
+/**
+ * @brief Gets the path of a library file, searching the directories in LD_LIBRARY_PATH for it if
+ * the library path is a bare file name. Returns the library path if the file is not found there.
+ */
+std::string findLibraryFile(const std::string & library_path)
+{
+#ifndef _WIN32
+  const char * search_path = std::getenv("LD_LIBRARY_PATH");
+  if (library_path.find('/') == std::string::npos && nullptr != search_path) {
+    std::stringstream directories(search_path);
+    std::string directory;
+    while (std::getline(directories, directory, ':')) {
+      if (!directory.empty() && fileExists(directory + "/" + library_path)) {
+        return directory + "/" + library_path;
+      }
+    }
+  }
+#endif
+  return library_path;
+}
+
+std::string findLibraryManifest(const std::string & library_path)
+{
+  std::string manifest_path = findLibraryFile(library_path) + ".classes";
+  return fileExists(manifest_path) ? manifest_path : std::string();
+}
+
+std::shared_ptr<const LibraryManifest> getCatalogManifest(const std::string & library_path);
+
+/**
+ * @brief Gets the manifest generated for a library by class_loader_generate_manifest(), which is
+ * read once, nullptr if there is none
+ */
+std::shared_ptr<const LibraryManifest> getGeneratedLibraryManifest(const std::string & library_path)
+{
+  boost::recursive_mutex::scoped_lock lock(getLibraryManifestMutex());
+  auto & manifests = getLibraryManifests();
+  auto itr = manifests.find(library_path);
+  if (itr != manifests.end()) {
+    return itr->second;
+  }
+
+  std::shared_ptr<LibraryManifest> manifest;
+  std::string manifest_path = findLibraryManifest(library_path);
+  if (!manifest_path.empty()) {
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader.impl: Reading manifest %s of library %s.",
+      manifest_path.c_str(), library_path.c_str());
+    manifest = std::make_shared<LibraryManifest>();
+    std::ifstream manifest_file(manifest_path.c_str());
+    std::string line;
+    while (std::getline(manifest_file, line)) {
+      std::stringstream fields(line);
+      std::string class_name, base_class_name;
+      if (fields >> class_name >> base_class_name) {
+        manifest->push_back(std::make_pair(base_class_name, class_name));
+      } else if (!line.empty()) {
+        CLASS_LOADER_LOG_WARN(
+          "class_loader.impl: Ignoring malformed line '%s' in manifest %s.",
+          line.c_str(), manifest_path.c_str());
+      }
+    }
+  }
+  manifests[library_path] = manifest;
+  return manifest;
+}
+
+std::shared_ptr<const LibraryManifest> getLibraryManifest(const std::string & library_path)
+{
+  std::shared_ptr<const LibraryManifest> manifest = getGeneratedLibraryManifest(library_path);
+  return nullptr != manifest ? manifest : getCatalogManifest(library_path);
+}
+
+bool hasLibraryManifest(const std::string & library_path)
+{
+  return nullptr != getLibraryManifest(library_path);
+}
+
+std::string normalizeClassName(std::string class_name)
+{
+  // MSVC prefixes the names returned by typeid with the kind of type
+  const char * prefixes[] = {"class ", "struct "};
+  for (auto & prefix : prefixes) {
+    if (0 == class_name.compare(0, std::string(prefix).size(), prefix)) {
+      class_name.erase(0, std::string(prefix).size());
+    }
+  }
+  class_name.erase(
+    std::remove_if(class_name.begin(), class_name.end(), ::isspace), class_name.end());
+  if (0 == class_name.compare(0, 2, "::")) {
+    class_name.erase(0, 2);
+  }
+  return class_name;
+}
+
+std::string demangleTypeidName(const std::string & typeid_name)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  int status = 0;
+  char * demangled = abi::__cxa_demangle(typeid_name.c_str(), nullptr, nullptr, &status);
+  if (0 == status && nullptr != demangled) {
+    std::string name(demangled);
+    std::free(demangled);
+    return normalizeClassName(name);
+  }
+  std::free(demangled);
+#endif
+  return normalizeClassName(typeid_name);
+}
+
+bool doesBaseClassNameMatch(const std::string & base_class_name, const std::string & demangled_name)
 {
-  static bool hasANonPurePluginLibraryBeenOpenedReference = false;
-  return hasANonPurePluginLibraryBeenOpenedReference;
+  // Note: Matching a namespace suffix would confuse base classes of the same name in different
+  // namespaces, the manifest has to spell them fully qualified
+  return normalizeClassName(base_class_name) == demangled_name;
 }
 
-bool hasANonPurePluginLibraryBeenOpened()
+bool getManifestClassesForLibrary(
+  const std::string & library_path, const std::string & typeid_base_class_name,
+  std::vector<std::string> & classes)
 {
-  return hasANonPurePluginLibraryBeenOpenedReference();
+  return forEachManifestClassForLibrary(
+    library_path, typeid_base_class_name,
+    [&classes](const std::string & class_name) {classes.push_back(class_name);});
 }
 
-void hasANonPurePluginLibraryBeenOpened(bool hasIt)
+bool forEachManifestClassForLibrary(
+  const std::string & library_path, const std::string & typeid_base_class_name,
+  const std::function<void(const std::string &)> & callback)
 {
-  hasANonPurePluginLibraryBeenOpenedReference() = hasIt;
+  std::shared_ptr<const LibraryManifest> manifest = getLibraryManifest(library_path);
+  if (nullptr == manifest) {
+    return false;
+  }
+  std::string demangled_name = demangleTypeidName(typeid_base_class_name);
+  for (auto & it : *manifest) {
+    if (doesBaseClassNameMatch(it.first, demangled_name)) {
+      callback(it.second);
+    }
+  }
+  return true;
 }
 
 
-// MetaObject search/insert/removal/query
+// Catalog
 
-MetaObjectVector allMetaObjects(const FactoryMap & factories)
+/**
+ * @brief Identifies the build of a library file a catalog entry was recorded for, an entry is
+ * ignored once the file has changed.
+ */
+struct CatalogKey
 {
-  MetaObjectVector all_meta_objs;
-  for (auto & it : factories) {
-    all_meta_objs.push_back(it.second);
+  uint64_t mtime_ns;
+  uint64_t size;
+  uint64_t inode;
+
+  bool operator==(const CatalogKey & other) const
+  {
+    return mtime_ns == other.mtime_ns && size == other.size && inode == other.inode;
   }
-  return all_meta_objs;
-}
+};
 
-MetaObjectVector allMetaObjects()
+/**
+ * @brief The header of a catalog entry file. It is followed by the length-prefixed path of the
+ * library file and by num_classes pairs of length-prefixed (base class, class) names, base classes
+ * as demangled typeid names. All integers are in native byte order.
+ */
+struct CatalogHeader
 {
-  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
-
-  MetaObjectVector all_meta_objs;
-  BaseToFactoryMapMap & factory_map_map = getGlobalPluginBaseToFactoryMapMap();
-  BaseToFactoryMapMap::iterator itr;
+  char magic[8];
+  uint32_t version;
+  uint32_t num_classes;
+  CatalogKey key;
+};
+
+const char kCatalogMagic[8] = {'C', 'L', 'C', 'A', 'T', 'A', 'L', 'G'};
+// Note: Bump on any change of the format, entries of other versions are rewritten on next load
+const uint32_t kCatalogVersion = 1;
+
+/**
+ * @brief A catalog entry read or written by this process
+ */
+struct CatalogEntry
+{
+  CatalogKey key;
+  std::shared_ptr<const LibraryManifest> manifest;
+};
 
-  for (auto & it : factory_map_map) {
-    MetaObjectVector objs = allMetaObjects(it.second);
-    all_meta_objs.insert(all_meta_objs.end(), objs.begin(), objs.end());
-  }
-  return all_meta_objs;
+std::string & getPluginCatalogDirectoryReference()
+{
+  // Note: Guarded by getLibraryManifestMutex()
+  static std::string instance = []() {
+      const char * directory = std::getenv("CLASS_LOADER_CATALOG_DIR");
+      return std::string(nullptr != directory ? directory : "");
+    }();
+  return instance;
 }
 
-MetaObjectVector
-filterAllMetaObjectsOwnedBy(const MetaObjectVector & to_filter, const ClassLoader * owner)
+std::unordered_map<LibraryPath, CatalogEntry> & getCatalogEntries()
 {
-  MetaObjectVector filtered_objs;
-  for (auto & f : to_filter) {
-    if (f->isOwnedBy(owner)) {
-      filtered_objs.push_back(f);
-    }
-  }
-  return filtered_objs;
+  // Note: Guarded by getLibraryManifestMutex()
+  static std::unordered_map<LibraryPath, CatalogEntry> instance;
+  return instance;
 }
 
-MetaObjectVector
-filterAllMetaObjectsAssociatedWithLibrary(
-  const MetaObjectVector & to_filter, const std::string & library_path)
+void setPluginCatalogDirectory(const std::string & directory)
 {
-  MetaObjectVector filtered_objs;
-  for (auto & f : to_filter) {
-    if (f->getAssociatedLibraryPath() == library_path) {
-      filtered_objs.push_back(f);
-    }
+  boost::recursive_mutex::scoped_lock lock(getLibraryManifestMutex());
+  if (getPluginCatalogDirectoryReference() != directory) {
+    getPluginCatalogDirectoryReference() = directory;
+    getCatalogEntries().clear();
   }
-  return filtered_objs;
 }
 
-MetaObjectVector
-allMetaObjectsForClassLoader(const ClassLoader * owner)
+std::string getPluginCatalogDirectory()
 {
-  return filterAllMetaObjectsOwnedBy(allMetaObjects(), owner);
+  boost::recursive_mutex::scoped_lock lock(getLibraryManifestMutex());
+  return getPluginCatalogDirectoryReference();
 }
 
-MetaObjectVector
-allMetaObjectsForLibrary(const std::string & library_path)
+#ifndef _WIN32
+/**
+ * @brief Resolves the file of a library the way findLibraryManifest() does and gets its catalog
+ * key, false if the file cannot be found
+ */
+bool getCatalogKey(const std::string & library_path, std::string & library_file, CatalogKey & key)
 {
-  return filterAllMetaObjectsAssociatedWithLibrary(allMetaObjects(), library_path);
+  char * real_path = realpath(findLibraryFile(library_path).c_str(), nullptr);
+  if (nullptr == real_path) {
+    return false;
+  }
+  library_file = real_path;
+  std::free(real_path);
+
+  struct stat file_status;
+  if (0 != stat(library_file.c_str(), &file_status)) {
+    return false;
+  }
+#ifdef __APPLE__
+  const struct timespec & mtime = file_status.st_mtimespec;
+#else
+  const struct timespec & mtime = file_status.st_mtim;
+#endif
+  key.mtime_ns = static_cast<uint64_t>(mtime.tv_sec) * 1000000000u +
+    static_cast<uint64_t>(mtime.tv_nsec);
+  key.size = static_cast<uint64_t>(file_status.st_size);
+  key.inode = static_cast<uint64_t>(file_status.st_ino);
+  return true;
 }
 
-MetaObjectVector
-allMetaObjectsForLibraryOwnedBy(const std::string & library_path, const ClassLoader * owner)
+/**
+ * @brief Gets the path of the catalog entry file of a library file, named after the 64-bit FNV-1a
+ * hash of the path of the library file so that all processes agree on it
+ */
+std::string getCatalogEntryPath(const std::string & directory, const std::string & library_file)
 {
-  return filterAllMetaObjectsOwnedBy(allMetaObjectsForLibrary(library_path), owner);
+  uint64_t hash = 14695981039346656037u;
+  for (unsigned char c : library_file) {
+    hash = (hash ^ c) * 1099511628211u;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.catalog", static_cast<unsigned long long>(hash));
+  return directory + "/" + name;
 }
 
-void insertMetaObjectIntoGraveyard(AbstractMetaObjectBase * meta_obj)
+/**
+ * @brief Parses a catalog entry file mapped into memory, nullptr if it is malformed or was recorded
+ * for another library file or build of it
+ */
+std::shared_ptr<const LibraryManifest> parseCatalogEntry(
+  const char * data, size_t size, const std::string & library_file, const CatalogKey & key)
 {
-  CONSOLE_BRIDGE_logDebug(
-    "class_loader.impl: "
-    "Inserting MetaObject (class = %s, base_class = %s, ptr = %p) into graveyard",
-    meta_obj->className().c_str(), meta_obj->baseClassName().c_str(),
-    reinterpret_cast<void *>(meta_obj));
-  getMetaObjectGraveyard().push_back(meta_obj);
-}
-
-void destroyMetaObjectsForLibrary(
-  const std::string & library_path, FactoryMap & factories, const ClassLoader * loader)
-{
-  FactoryMap::iterator factory_itr = factories.begin();
-  while (factory_itr != factories.end()) {
-    AbstractMetaObjectBase * meta_obj = factory_itr->second;
-    if (meta_obj->getAssociatedLibraryPath() == library_path && meta_obj->isOwnedBy(loader)) {
-      meta_obj->removeOwningClassLoader(loader);
-      if (!meta_obj->isOwnedByAnybody()) {
-        FactoryMap::iterator factory_itr_copy = factory_itr;
-        factory_itr++;
-        // TODO(mikaelarguedas) fix this when branching out for melodic
-        // Note: map::erase does not return iterator like vector::erase does.
-        // Hence the ugliness of this code and a need for copy. Should be fixed in next C++ revision
-        factories.erase(factory_itr_copy);
-
-        // Insert into graveyard
-        // We remove the metaobject from its factory map, but we don't destroy it...instead it
-        // saved to a "graveyard" to the side.
-        // This is due to our static global variable initialization problem that causes factories
-        // to not be registered when a library is closed and then reopened.
-        // This is because it's truly not closed due to the use of global symbol binding i.e.
-        // calling dlopen with RTLD_GLOBAL instead of RTLD_LOCAL.
-        // We require using the former as the which is required to support RTTI
-        insertMetaObjectIntoGraveyard(meta_obj);
-      } else {
-        ++factory_itr;
+  CatalogHeader header;
+  if (size < sizeof(header)) {
+    return nullptr;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (0 != std::memcmp(header.magic, kCatalogMagic, sizeof(kCatalogMagic)) ||
+    kCatalogVersion != header.version || !(header.key == key))
+  {
+    return nullptr;
+  }
+
+  size_t offset = sizeof(header);
+  auto read_string = [data, size, &offset](std::string & string) {
+      uint32_t length = 0;
+      if (size - offset < sizeof(length)) {
+        return false;
       }
-    } else {
-      ++factory_itr;
+      std::memcpy(&length, data + offset, sizeof(length));
+      offset += sizeof(length);
+      if (size - offset < length) {
+        return false;
+      }
+      string.assign(data + offset, length);
+      offset += length;
+      return true;
+    };
+
+  std::string recorded_library_file;
+  if (!read_string(recorded_library_file) || recorded_library_file != library_file) {
+    return nullptr;
+  }
+  std::shared_ptr<LibraryManifest> manifest = std::make_shared<LibraryManifest>();
+  for (uint32_t i = 0; i < header.num_classes; ++i) {
+    std::string base_class_name, class_name;
+    if (!read_string(base_class_name) || !read_string(class_name)) {
+      return nullptr;
     }
+    manifest->push_back(std::make_pair(base_class_name, class_name));
   }
+  return manifest;
 }
 
-void destroyMetaObjectsForLibrary(const std::string & library_path, const ClassLoader * loader)
+/**
+ * @brief Maps a catalog entry file into memory and parses it, @see parseCatalogEntry()
+ */
+std::shared_ptr<const LibraryManifest> readCatalogEntry(
+  const std::string & entry_path, const std::string & library_file, const CatalogKey & key)
 {
-  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
-
-  CONSOLE_BRIDGE_logDebug(
-    "class_loader.impl: "
-    "Removing MetaObjects associated with library %s and class loader %p from global "
-    "plugin-to-factorymap map.\n",
-    library_path.c_str(), reinterpret_cast<const void *>(loader));
-
-  // We have to walk through all FactoryMaps to be sure
-  BaseToFactoryMapMap & factory_map_map = getGlobalPluginBaseToFactoryMapMap();
-  for (auto & it : factory_map_map) {
-    destroyMetaObjectsForLibrary(library_path, it.second, loader);
+  int fd = open(entry_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_status;
+  if (0 != fstat(fd, &file_status) || file_status.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+  size_t size = static_cast<size_t>(file_status.st_size);
+  void * data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MAP_FAILED == data) {
+    return nullptr;
   }
+  std::shared_ptr<const LibraryManifest> manifest =
+    parseCatalogEntry(static_cast<const char *>(data), size, library_file, key);
+  munmap(data, size);
+  return manifest;
+}
 
-  CONSOLE_BRIDGE_logDebug("%s", "class_loader.impl: Metaobjects removed.");
+/**
+ * @brief Writes a catalog entry file. It is written to a temporary file first and then renamed,
+ * so that other processes never read a partially written entry.
+ */
+bool writeCatalogEntry(
+  const std::string & entry_path, const std::string & library_file, const CatalogKey & key,
+  const LibraryManifest & manifest)
+{
+  std::string temporary_path = entry_path + "." + std::to_string(getpid()) + ".tmp";
+  {
+    std::ofstream file(temporary_path.c_str(), std::ios::binary | std::ios::trunc);
+    auto write_string = [&file](const std::string & string) {
+        uint32_t length = static_cast<uint32_t>(string.size());
+        file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        file.write(string.data(), string.size());
+      };
+
+    CatalogHeader header;
+    std::memcpy(header.magic, kCatalogMagic, sizeof(kCatalogMagic));
+    header.version = kCatalogVersion;
+    header.num_classes = static_cast<uint32_t>(manifest.size());
+    header.key = key;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write_string(library_file);
+    for (auto & it : manifest) {
+      write_string(it.first);
+      write_string(it.second);
+    }
+    if (!file.flush()) {
+      std::remove(temporary_path.c_str());
+      return false;
+    }
+  }
+  if (0 != std::rename(temporary_path.c_str(), entry_path.c_str())) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+  return true;
 }
 
-bool areThereAnyExistingMetaObjectsForLibrary(const std::string & library_path)
+std::shared_ptr<const LibraryManifest> getCatalogManifest(const std::string & library_path)
 {
-  return allMetaObjectsForLibrary(library_path).size() > 0;
+  boost::recursive_mutex::scoped_lock lock(getLibraryManifestMutex());
+  const std::string & directory = getPluginCatalogDirectoryReference();
+  std::string library_file;
+  CatalogKey key;
+  if (directory.empty() || !getCatalogKey(library_path, library_file, key)) {
+    return nullptr;
+  }
+
+  auto & entries = getCatalogEntries();
+  auto itr = entries.find(library_path);
+  if (itr != entries.end() && itr->second.key == key) {
+    return itr->second.manifest;
+  }
+  // Note: Missing entries are looked up again every time, as another process may record them
+  std::shared_ptr<const LibraryManifest> manifest =
+    readCatalogEntry(getCatalogEntryPath(directory, library_file), library_file, key);
+  if (nullptr != manifest) {
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader.impl: Read catalog entry of library %s.", library_path.c_str());
+    CatalogEntry entry = {key, manifest};
+    entries[library_path] = entry;
+  }
+  return manifest;
 }
 
-// Loaded Library Vector manipulation
-LibraryVector::iterator findLoadedLibrary(const std::string & library_path)
+void recordLibraryInCatalog(const std::string & library_path)
 {
-  LibraryVector & open_libraries = getLoadedLibraryVector();
-  for (auto it = open_libraries.begin(); it != open_libraries.end(); ++it) {
-    if (it->first == library_path) {
-      return it;
-    }
+  if (getPluginCatalogDirectory().empty()) {
+    return;
+  }
+  std::shared_ptr<LibraryManifest> manifest = std::make_shared<LibraryManifest>();
+  for (auto & meta_obj : allMetaObjectsForLibrary(library_path)) {
+    manifest->push_back(
+      std::make_pair(demangleTypeidName(meta_obj->typeidBaseClassName()), meta_obj->className()));
+  }
+
+  boost::recursive_mutex::scoped_lock lock(getLibraryManifestMutex());
+  const std::string & directory = getPluginCatalogDirectoryReference();
+  std::string library_file;
+  CatalogKey key;
+  if (manifest->empty() || directory.empty() || nullptr != getCatalogManifest(library_path) ||
+    !getCatalogKey(library_path, library_file, key))
+  {
+    return;
+  }
+  // Note: Only the last directory of the path is created
+  mkdir(directory.c_str(), 0777);
+  std::string entry_path = getCatalogEntryPath(directory, library_file);
+  if (!writeCatalogEntry(entry_path, library_file, key, *manifest)) {
+    CLASS_LOADER_LOG_WARN(
+      "class_loader.impl: Could not record library %s in the catalog %s.",
+      library_path.c_str(), directory.c_str());
+    return;
   }
-  return open_libraries.end();
+  CLASS_LOADER_LOG_DEBUG(
+    "class_loader.impl: Recorded library %s in the catalog %s.",
+    library_path.c_str(), directory.c_str());
+  CatalogEntry entry = {key, manifest};
+  getCatalogEntries()[library_path] = entry;
+}
+#else
+// Note: The catalog is not supported on Windows yet
+std::shared_ptr<const LibraryManifest> getCatalogManifest(const std::string &)
+{
+  return nullptr;
 }
 
-bool isLibraryLoadedByAnybody(const std::string & library_path)
+void recordLibraryInCatalog(const std::string &)
 {
-  boost::recursive_mutex::scoped_lock lock(getLoadedLibraryVectorMutex());
+}
+#endif
 
-  LibraryVector & open_libraries = getLoadedLibraryVector();
-  LibraryVector::iterator itr = findLoadedLibrary(library_path);
 
-  if (itr != open_libraries.end()) {
-    assert(itr->second->isLoaded() == true);  // Ensure Poco actually thinks the library is loaded
-    return true;
-  } else {
+// Dependencies
+
+#ifdef __linux__
+/**
+ * @brief Reads the section headers of an ELF library of the native word size
+ * @return false if the file is no such library
+ */
+bool readElfSections(std::ifstream & file, std::vector<ElfW(Shdr)> & sections)
+{
+  ElfW(Ehdr) header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+    0 != std::memcmp(header.e_ident, ELFMAG, SELFMAG) ||
+    header.e_ident[EI_CLASS] != (sizeof(void *) == 8 ? ELFCLASS64 : ELFCLASS32) ||
+    header.e_shentsize != sizeof(ElfW(Shdr)))
+  {
     return false;
   }
+  sections.resize(header.e_shnum);
+  file.seekg(header.e_shoff);
+  return static_cast<bool>(
+    file.read(reinterpret_cast<char *>(sections.data()), sections.size() * sizeof(ElfW(Shdr))));
 }
+#endif
 
-bool isLibraryLoaded(const std::string & library_path, ClassLoader * loader)
+std::vector<std::string> getNeededLibraries(const std::string & library_path)
 {
-  bool is_lib_loaded_by_anyone = isLibraryLoadedByAnybody(library_path);
-  size_t num_meta_objs_for_lib = allMetaObjectsForLibrary(library_path).size();
-  size_t num_meta_objs_for_lib_bound_to_loader =
-    allMetaObjectsForLibraryOwnedBy(library_path, loader).size();
-  bool are_meta_objs_bound_to_loader =
-    (0 == num_meta_objs_for_lib) ? true : (
-    num_meta_objs_for_lib_bound_to_loader <= num_meta_objs_for_lib);
+  std::vector<std::string> needed_libraries;
+#ifdef __linux__
+  std::ifstream file(findLibraryFile(library_path).c_str(), std::ios::binary);
+  std::vector<ElfW(Shdr)> sections;
+  if (!readElfSections(file, sections)) {
+    return needed_libraries;
+  }
 
-  return is_lib_loaded_by_anyone && are_meta_objs_bound_to_loader;
+  // Note: The dynamic section refers to the names of the needed libraries by offset into the
+  // string table its sh_link designates
+  for (auto & section : sections) {
+    if (section.sh_type != SHT_DYNAMIC || section.sh_link >= sections.size()) {
+      continue;
+    }
+    const ElfW(Shdr) & string_section = sections[section.sh_link];
+    std::vector<ElfW(Dyn)> entries(section.sh_size / sizeof(ElfW(Dyn)));
+    std::string strings(string_section.sh_size, '\0');
+    file.seekg(section.sh_offset);
+    file.read(reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(ElfW(Dyn)));
+    file.seekg(string_section.sh_offset);
+    file.read(&strings[0], strings.size());
+    if (!file) {
+      break;
+    }
+    for (auto & entry : entries) {
+      if (entry.d_tag == DT_NULL) {
+        break;
+      }
+      if (entry.d_tag == DT_NEEDED && entry.d_un.d_val < strings.size()) {
+        needed_libraries.push_back(strings.c_str() + entry.d_un.d_val);
+      }
+    }
+  }
+#else
+  (void)library_path;
+#endif
+  return needed_libraries;
 }
 
-std::vector<std::string> getAllLibrariesUsedByClassLoader(const ClassLoader * loader)
+std::vector<std::string> getSymbolsInterposedByLibrary(
+  const std::string & library_path, const std::string & loaded_library_path)
 {
-  MetaObjectVector all_loader_meta_objs = allMetaObjectsForClassLoader(loader);
-  std::vector<std::string> all_libs;
-  for (auto & meta_obj : all_loader_meta_objs) {
-    std::string lib_path = meta_obj->getAssociatedLibraryPath();
-    if (std::find(all_libs.begin(), all_libs.end(), lib_path) == all_libs.end()) {
-      all_libs.push_back(lib_path);
+  std::vector<std::string> symbols;
+#ifdef __linux__
+  std::ifstream file(findLibraryFile(library_path).c_str(), std::ios::binary);
+  std::vector<ElfW(Shdr)> sections;
+  if (!readElfSections(file, sections)) {
+    return symbols;
+  }
+  // Note: The handle also keeps the loaded library mapped while its symbols are looked up
+  void * handle = dlopen(loaded_library_path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+  if (nullptr == handle) {
+    return symbols;
+  }
+  struct link_map * loaded_link_map = nullptr;
+  if (0 != dlinfo(handle, RTLD_DI_LINKMAP, &loaded_link_map)) {
+    loaded_link_map = nullptr;
+  }
+
+  // Note: The dynamic symbol table refers to the names of the symbols by offset into the string
+  // table its sh_link designates
+  for (auto & section : sections) {
+    if (nullptr == loaded_link_map) {
+      break;
+    }
+    if (section.sh_type != SHT_DYNSYM || section.sh_link >= sections.size()) {
+      continue;
+    }
+    const ElfW(Shdr) & string_section = sections[section.sh_link];
+    std::vector<ElfW(Sym)> entries(section.sh_size / sizeof(ElfW(Sym)));
+    std::string strings(string_section.sh_size, '\0');
+    file.seekg(section.sh_offset);
+    file.read(reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(ElfW(Sym)));
+    file.seekg(string_section.sh_offset);
+    file.read(&strings[0], strings.size());
+    if (!file) {
+      break;
+    }
+    // Note: The ELF32_ST_* and ELF64_ST_* macros are the same
+    for (auto & entry : entries) {
+      const unsigned char binding = ELF64_ST_BIND(entry.st_info);
+      const unsigned char type = ELF64_ST_TYPE(entry.st_info);
+      if (SHN_UNDEF == entry.st_shndx || entry.st_name >= strings.size() ||
+        (STB_GLOBAL != binding && STB_WEAK != binding) ||
+        (STT_FUNC != type && STT_OBJECT != type) ||
+        STV_DEFAULT != ELF64_ST_VISIBILITY(entry.st_other))
+      {
+        continue;
+      }
+      const char * name = strings.c_str() + entry.st_name;
+      void * address = dlsym(RTLD_DEFAULT, name);
+      Dl_info info;
+      struct link_map * defining_link_map = nullptr;
+      if (nullptr == address ||
+        0 == dladdr1(
+          address, &info, reinterpret_cast<void **>(&defining_link_map), RTLD_DL_LINKMAP) ||
+        defining_link_map != loaded_link_map)
+      {
+        continue;
+      }
+#if defined(__GNUC__) || defined(__clang__)
+      int status = 0;
+      char * demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+      symbols.push_back(0 == status && nullptr != demangled ? demangled : name);
+      std::free(demangled);
+#else
+      symbols.push_back(name);
+#endif
     }
   }
-  return all_libs;
+  dlclose(handle);
+#else
+  static_cast<void>(library_path);
+  static_cast<void>(loaded_library_path);
+#endif
+  return symbols;
 }
 
 
@@ -335,162 +1954,165 @@ void addClassLoaderOwnerForAllExistingMetaObjectsForLibrary(
 {
   MetaObjectVector all_meta_objs = allMetaObjectsForLibrary(library_path);
   for (auto & meta_obj : all_meta_objs) {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader.impl: "
       "Tagging existing MetaObject %p (base = %s, derived = %s) with "
       "class loader %p (library path = %s).",
       reinterpret_cast<void *>(meta_obj), meta_obj->baseClassName().c_str(),
       meta_obj->className().c_str(),
       reinterpret_cast<void *>(loader),
-      nullptr == loader ? loader->getLibraryPath().c_str() : "NULL");
-    meta_obj->addOwningClassLoader(loader);
+      nullptr != loader ? loader->getLibraryPath().c_str() : "NULL");
+    addMetaObjectOwner(meta_obj, loader);
   }
 }
 
 void revivePreviouslyCreateMetaobjectsFromGraveyard(
   const std::string & library_path, ClassLoader * loader)
 {
+  ScopedTrace trace(TRACE_GRAVEYARD_REVIVE, library_path);
   boost::recursive_mutex::scoped_lock b2fmm_lock(getPluginBaseToFactoryMapMapMutex());
-  MetaObjectVector & graveyard = getMetaObjectGraveyard();
+  MetaObjectGraveyard & graveyard = getMetaObjectGraveyard();
+  MetaObjectGraveyard::iterator itr = graveyard.find(findSymbol(library_path));
+  MetaObjectVector revived;
+  if (itr != graveyard.end()) {
+    revived.swap(itr->second);
+    graveyard.erase(itr);
+  }
 
-  for (auto & obj : graveyard) {
-    if (obj->getAssociatedLibraryPath() == library_path) {
-      CONSOLE_BRIDGE_logDebug(
-        "class_loader.impl: "
-        "Resurrected factory metaobject from graveyard, class = %s, base_class = %s ptr = %p..."
-        "bound to ClassLoader %p (library path = %s)",
-        obj->className().c_str(), obj->baseClassName().c_str(), reinterpret_cast<void *>(obj),
-        reinterpret_cast<void *>(loader),
-        nullptr == loader ? loader->getLibraryPath().c_str() : "NULL");
+  for (auto & obj : revived) {
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader.impl: "
+      "Resurrected factory metaobject from graveyard, class = %s, base_class = %s ptr = %p..."
+      "bound to ClassLoader %p (library path = %s)",
+      obj->className().c_str(), obj->baseClassName().c_str(), reinterpret_cast<void *>(obj),
+      reinterpret_cast<void *>(loader),
+      nullptr != loader ? loader->getLibraryPath().c_str() : "NULL");
 
-      obj->addOwningClassLoader(loader);
-      assert(obj->typeidBaseClassName() != "UNSET");
-      FactoryMap & factory = getFactoryMapForBaseClass(obj->typeidBaseClassName());
-      factory[obj->className()] = obj;
-    }
+    assert(obj->typeidBaseClassName() != "UNSET");
+    FactoryMap & factory = getFactoryMapForBaseClass(obj->typeidBaseClassId());
+    insertMetaObjectIntoFactoryMap(factory, obj);
+    addMetaObjectOwner(obj, loader);
   }
+  size_t num_revived = revived.size();
+  updateLibraryStatistics(library_path, [num_revived](LibraryStatistics & stats) {
+      stats.graveyard_revival_count += num_revived;
+    });
 }
 
 void purgeGraveyardOfMetaobjects(
   const std::string & library_path, ClassLoader * loader, bool delete_objs)
 {
-  MetaObjectVector all_meta_objs = allMetaObjects();
-  // Note: Lock must happen after call to allMetaObjects as that will lock
+  ScopedTrace trace(TRACE_GRAVEYARD_PURGE, library_path);
   boost::recursive_mutex::scoped_lock b2fmm_lock(getPluginBaseToFactoryMapMapMutex());
+  MetaObjectGraveyard & graveyard = getMetaObjectGraveyard();
+  MetaObjectGraveyard::iterator itr = graveyard.find(findSymbol(library_path));
+  MetaObjectVector purged;
+  if (itr != graveyard.end()) {
+    purged.swap(itr->second);
+    graveyard.erase(itr);
+  }
 
-  MetaObjectVector & graveyard = getMetaObjectGraveyard();
-  MetaObjectVector::iterator itr = graveyard.begin();
+  for (auto & obj : purged) {
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader.impl: "
+      "Purging factory metaobject from graveyard, class = %s, base_class = %s ptr = %p.."
+      ".bound to ClassLoader %p (library path = %s)",
+      obj->className().c_str(), obj->baseClassName().c_str(), reinterpret_cast<void *>(obj),
+      reinterpret_cast<void *>(loader),
+      nullptr != loader ? loader->getLibraryPath().c_str() : "NULL");
 
-  while (itr != graveyard.end()) {
-    AbstractMetaObjectBase * obj = *itr;
-    if (obj->getAssociatedLibraryPath() == library_path) {
-      CONSOLE_BRIDGE_logDebug(
+    if (!delete_objs) {
+      continue;
+    }
+    if (isMetaObjectInFactoryMap(obj)) {
+      CLASS_LOADER_LOG_DEBUG("%s",
         "class_loader.impl: "
-        "Purging factory metaobject from graveyard, class = %s, base_class = %s ptr = %p.."
-        ".bound to ClassLoader %p (library path = %s)",
-        obj->className().c_str(), obj->baseClassName().c_str(), reinterpret_cast<void *>(obj),
-        reinterpret_cast<void *>(loader),
-        nullptr == loader ? loader->getLibraryPath().c_str() : "NULL");
-
-      bool is_address_in_graveyard_same_as_global_factory_map =
-        std::find(all_meta_objs.begin(), all_meta_objs.end(), *itr) != all_meta_objs.end();
-      itr = graveyard.erase(itr);
-      if (delete_objs) {
-        if (is_address_in_graveyard_same_as_global_factory_map) {
-          CONSOLE_BRIDGE_logDebug("%s",
-            "class_loader.impl: "
-            "Newly created metaobject factory in global factory map map has same address as "
-            "one in graveyard -- metaobject has been purged from graveyard but not deleted.");
-        } else {
-          assert(hasANonPurePluginLibraryBeenOpened() == false);
-          CONSOLE_BRIDGE_logDebug(
-            "class_loader.impl: "
-            "Also destroying metaobject %p (class = %s, base_class = %s, library_path = %s) "
-            "in addition to purging it from graveyard.",
-            reinterpret_cast<void *>(obj), obj->className().c_str(), obj->baseClassName().c_str(),
-            obj->getAssociatedLibraryPath().c_str());
+        "Newly created metaobject factory in global factory map map has same address as "
+        "one in graveyard -- metaobject has been purged from graveyard but not deleted.");
+    } else {
+      assert(hasANonPurePluginLibraryBeenOpened() == false);
+      CLASS_LOADER_LOG_DEBUG(
+        "class_loader.impl: "
+        "Also destroying metaobject %p (class = %s, base_class = %s, library_path = %s) "
+        "in addition to purging it from graveyard.",
+        reinterpret_cast<void *>(obj), obj->className().c_str(), obj->baseClassName().c_str(),
+        obj->getAssociatedLibraryPath().c_str());
 #ifndef _WIN32
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
 #endif
-          delete (obj);  // Note: This is the only place where metaobjects can be destroyed
+      retireClassStatistics(obj);
+      delete (obj);  // Note: This is the only place where metaobjects can be destroyed
 #ifndef _WIN32
 #pragma GCC diagnostic pop
 #endif
-        }
-      }
-    } else {
-      itr++;
     }
   }
+  if (delete_objs) {
+    size_t num_purged = purged.size();
+    updateLibraryStatistics(library_path, [num_purged](LibraryStatistics & stats) {
+        stats.graveyard_purge_count += num_purged;
+      });
+  }
 }
 
 void loadLibrary(const std::string & library_path, ClassLoader * loader)
 {
-  static boost::recursive_mutex loader_mutex;
-  CONSOLE_BRIDGE_logDebug(
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.impl: "
     "Attempting to load library %s on behalf of ClassLoader handle %p...\n",
     library_path.c_str(), reinterpret_cast<void *>(loader));
-  boost::recursive_mutex::scoped_lock loader_lock(loader_mutex);
+  // Note: Only loads/unloads of the same library need to be serialized, different libraries can
+  // be opened concurrently as registration state is kept per thread.
+  boost::recursive_mutex::scoped_lock loader_lock(getLibraryMutex(library_path));
 
   // If it's already open, just update existing metaobjects to have an additional owner.
   if (isLibraryLoadedByAnybody(library_path)) {
     boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
-    CONSOLE_BRIDGE_logDebug("%s",
+    CLASS_LOADER_LOG_DEBUG("%s",
       "class_loader.impl: "
       "Library already in memory, but binding existing MetaObjects to loader if necesesary.\n");
     addClassLoaderOwnerForAllExistingMetaObjectsForLibrary(library_path, loader);
     return;
   }
 
-  Poco::SharedLibrary * library_handle = nullptr;
+  LibraryBackend & backend = getLibraryBackend();
+  int flags = nullptr == loader ? LIBRARY_LOAD_DEFAULT : loader->getLibraryLoadFlags();
+  LibraryHandle library_handle = nullptr;
+  uint64_t registration_time_ns = getRegistrationTimeReference();
+  std::chrono::steady_clock::time_point dlopen_start = std::chrono::steady_clock::now();
 
   {
-    try {
-      setCurrentlyActiveClassLoader(loader);
-      setCurrentlyLoadingLibraryName(library_path);
-      library_handle = new Poco::SharedLibrary(library_path);
-    } catch (const Poco::LibraryLoadException & e) {
-      setCurrentlyLoadingLibraryName("");
-      setCurrentlyActiveClassLoader(nullptr);
-      throw class_loader::LibraryLoadException(
-              "Could not load library (Poco exception = " + std::string(e.message()) + ")");
-    } catch (const Poco::LibraryAlreadyLoadedException & e) {
-      setCurrentlyLoadingLibraryName("");
-      setCurrentlyActiveClassLoader(nullptr);
-      throw class_loader::LibraryLoadException(
-              "Library already loaded (Poco exception = " + std::string(e.message()) + ")");
-    } catch (const Poco::NotFoundException & e) {
-      setCurrentlyLoadingLibraryName("");
-      setCurrentlyActiveClassLoader(nullptr);
-      throw class_loader::LibraryLoadException(
-              "Library not found (Poco exception = " + std::string(e.message()) + ")");
-    }
-
-    setCurrentlyLoadingLibraryName("");
-    setCurrentlyActiveClassLoader(nullptr);
+    ScopedLoadingContext loading_context(library_path, loader);
+    ScopedTrace trace(TRACE_LIBRARY_OPEN, library_path);
+    library_handle = backend.open(library_path, flags);
   }
 
   assert(library_handle != nullptr);
-  CONSOLE_BRIDGE_logDebug(
+  uint64_t dlopen_time_ns = elapsedNanoseconds(dlopen_start);
+  registration_time_ns = getRegistrationTimeReference() - registration_time_ns;
+  updateLibraryStatistics(library_path, [&](LibraryStatistics & stats) {
+      ++stats.load_count;
+      stats.dlopen_time_ns += dlopen_time_ns;
+      stats.registration_time_ns += registration_time_ns;
+    });
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.impl: "
-    "Successfully loaded library %s into memory (Poco::SharedLibrary handle = %p).",
-    library_path.c_str(), reinterpret_cast<void *>(library_handle));
+    "Successfully loaded library %s into memory (handle = %p, flags = %d).",
+    library_path.c_str(), library_handle, flags);
 
   // Graveyard scenario
-  size_t num_lib_objs = allMetaObjectsForLibrary(library_path).size();
+  size_t num_lib_objs = numMetaObjectsForLibrary(library_path);
   if (0 == num_lib_objs) {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader.impl: "
       "Though the library %s was just loaded, it seems no factory metaobjects were registered. "
       "Checking factory graveyard for previously loaded metaobjects...",
       library_path.c_str());
+    // Note: Reviving takes the metaobjects out of the graveyard, there is nothing left to purge
     revivePreviouslyCreateMetaobjectsFromGraveyard(library_path, loader);
-    // Note: The 'false' indicates we don't want to invoke delete on the metaobject
-    purgeGraveyardOfMetaobjects(library_path, loader, false);
   } else {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader.impl: "
       "Library %s generated new factory metaobjects on load. "
       "Destroying graveyarded objects from previous loads...",
@@ -498,17 +2120,21 @@ void loadLibrary(const std::string & library_path, ClassLoader * loader)
     purgeGraveyardOfMetaobjects(library_path, loader, true);
   }
 
-  // Insert library into global loaded library vector
+  // Note: Staged loads open snapshots of libraries, which are not worth recording
+  if (!isStagingRegistrations()) {
+    recordLibraryInCatalog(library_path);
+  }
+
+  // Insert library into global loaded library map
   boost::recursive_mutex::scoped_lock llv_lock(getLoadedLibraryVectorMutex());
-  LibraryVector & open_libraries = getLoadedLibraryVector();
-  // Note: Poco::SharedLibrary automatically calls load() when library passed to constructor
-  open_libraries.push_back(LibraryPair(library_path, library_handle));
+  LoadedLibrary library = {library_handle, &backend, flags};
+  getLoadedLibraryMap()[internSymbol(library_path)] = library;
 }
 
 void unloadLibrary(const std::string & library_path, ClassLoader * loader)
 {
   if (hasANonPurePluginLibraryBeenOpened()) {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader.impl: "
       "Cannot unload %s or ANY other library as a non-pure plugin library was opened. "
       "As class_loader has no idea which libraries class factories were exported from, "
@@ -518,47 +2144,334 @@ void unloadLibrary(const std::string & library_path, ClassLoader * loader)
       "in order for this error to stop happening.",
       library_path.c_str());
   } else {
-    CONSOLE_BRIDGE_logDebug(
+    CLASS_LOADER_LOG_DEBUG(
       "class_loader.impl: "
       "Unloading library %s on behalf of ClassLoader %p...",
       library_path.c_str(), reinterpret_cast<void *>(loader));
+    boost::recursive_mutex::scoped_lock loader_lock(getLibraryMutex(library_path));
+    LoadedLibrary library = {nullptr, nullptr, LIBRARY_LOAD_DEFAULT};
+    {
+      boost::recursive_mutex::scoped_lock lock(getLoadedLibraryVectorMutex());
+      LibraryMap & open_libraries = getLoadedLibraryMap();
+      LibraryMap::iterator itr = findLoadedLibrary(library_path);
+      if (itr == open_libraries.end()) {
+        throw class_loader::LibraryUnloadException(
+                "Attempt to unload library that class_loader is unaware of.");
+      }
+      destroyMetaObjectsForLibrary(library_path, loader);
+
+      // Remove from loaded library map as well if no more factories associated with said library
+      if (!areThereAnyExistingMetaObjectsForLibrary(library_path)) {
+        CLASS_LOADER_LOG_DEBUG(
+          "class_loader.impl: "
+          "There are no more MetaObjects left for %s so unloading library and "
+          "removing from loaded library map.\n",
+          library_path.c_str());
+        library = itr->second;
+        open_libraries.erase(itr);
+        updateLibraryStatistics(library_path, [](LibraryStatistics & stats) {
+            ++stats.unload_count;
+          });
+      } else {
+        CLASS_LOADER_LOG_DEBUG(
+          "class_loader.impl: "
+          "MetaObjects still remain in memory meaning other ClassLoaders are still using library"
+          ", keeping library %s open.",
+          library_path.c_str());
+      }
+    }
+    // Note: Closing the library runs its static destructors, only the mutex of the library is
+    // held meanwhile so that loads and unloads of other libraries are not stalled
+    if (nullptr != library.handle) {
+      ScopedTrace trace(TRACE_LIBRARY_CLOSE, library_path);
+      library.backend->close(library.handle);
+    }
+  }
+}
+
+// Reloads
+
+void publishLibraryFactories(const std::string & library_path)
+{
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  for (auto & meta_obj : allMetaObjectsForLibrary(library_path)) {
+    publishMetaObject(getFactoryMapForBaseClass(meta_obj->typeidBaseClassId()), meta_obj);
+  }
+}
+
+#ifndef _WIN32
+std::string createLibrarySnapshot(const std::string & library_path)
+{
+  static std::atomic<size_t> snapshot_count(0);
+  std::string library_file = findLibraryFile(library_path);
+  const char * directory = std::getenv("TMPDIR");
+  std::ostringstream snapshot_path;
+  snapshot_path << (nullptr != directory && '\0' != *directory ? directory : "/tmp") <<
+    "/class_loader_" << getpid() << "_" << snapshot_count++ << "_" <<
+    library_file.substr(library_file.find_last_of('/') + 1);
+
+  std::ifstream source(library_file.c_str(), std::ios::binary);
+  std::ofstream snapshot(snapshot_path.str().c_str(), std::ios::binary | std::ios::trunc);
+  if (!source || !snapshot || !(snapshot << source.rdbuf()) || !snapshot.flush()) {
+    snapshot.close();
+    std::remove(snapshot_path.str().c_str());
+    throw class_loader::LibraryLoadException(
+            "Could not copy library " + library_file + " to " + snapshot_path.str());
+  }
+  return snapshot_path.str();
+}
+#else
+// Note: Reloads are not supported on Windows yet
+std::string createLibrarySnapshot(const std::string & library_path)
+{
+  throw class_loader::LibraryLoadException(
+          "Could not copy library " + library_path + ", reloads are not supported on Windows");
+}
+#endif
+
+void discardLibrarySnapshot(const std::string & snapshot_path)
+{
+  if (isLibraryLoadedByAnybody(snapshot_path)) {
+    return;
+  }
+  // Note: The copy is never opened again, so its graveyarded factories would never be revived
+  purgeGraveyardOfMetaobjects(snapshot_path, nullptr, true);
+  std::remove(snapshot_path.c_str());
+}
+
+
+// Memory
+
+/**
+ * @brief The slabs metaobjects are allocated from (@see allocateMetaObjectStorage()), with a list
+ * of the free slots of each slot size threaded through the slots themselves
+ */
+struct MetaObjectArena
+{
+  MetaObjectArena()
+  : bytes_reserved_(0) {}
+
+  struct Slab
+  {
+    size_t slot_size_;
+    char * storage_;
+  };
+
+  boost::mutex mutex_;
+  // Note: By the address one past the end of each slab, so that upper_bound() finds the slab
+  // of a slot
+  std::map<uintptr_t, Slab> slabs_;
+  std::map<size_t, void *> free_slots_;
+  size_t bytes_reserved_;
+};
+
+const size_t kMetaObjectSlotsPerSlab = 32;
+
+MetaObjectArena & getMetaObjectArena()
+{
+  // Note: Never destroyed, metaobjects of ClassLoaders with static storage duration may be
+  // freed after it would be
+  static MetaObjectArena * instance = new MetaObjectArena();
+  return *instance;
+}
+
+void * allocateMetaObjectStorage(size_t size)
+{
+  const size_t alignment = alignof(std::max_align_t);
+  size_t slot_size = (std::max(size, sizeof(void *)) + alignment - 1) / alignment * alignment;
+  MetaObjectArena & arena = getMetaObjectArena();
+  boost::mutex::scoped_lock lock(arena.mutex_);
+  void * & free_slot = arena.free_slots_[slot_size];
+  if (nullptr == free_slot) {
+    size_t slab_size = slot_size * kMetaObjectSlotsPerSlab;
+    MetaObjectArena::Slab slab = {slot_size, static_cast<char *>(::operator new(slab_size))};
+    arena.slabs_.insert(
+      std::make_pair(reinterpret_cast<uintptr_t>(slab.storage_ + slab_size), slab));
+    arena.bytes_reserved_ += slab_size;
+    for (size_t i = kMetaObjectSlotsPerSlab; i > 0; --i) {
+      void * slot = slab.storage_ + (i - 1) * slot_size;
+      *static_cast<void **>(slot) = free_slot;
+      free_slot = slot;
+    }
+  }
+  void * slot = free_slot;
+  free_slot = *static_cast<void **>(slot);
+  // Note: ClassLoader::Deleter keeps a flag in the lowest bit of the address
+  assert(0 == reinterpret_cast<uintptr_t>(slot) % alignment);
+  return slot;
+}
+
+void freeMetaObjectStorage(void * storage)
+{
+  if (nullptr == storage) {
+    return;
+  }
+  MetaObjectArena & arena = getMetaObjectArena();
+  boost::mutex::scoped_lock lock(arena.mutex_);
+  auto slab_itr = arena.slabs_.upper_bound(reinterpret_cast<uintptr_t>(storage));
+  assert(slab_itr != arena.slabs_.end());
+  void * & free_slot = arena.free_slots_[slab_itr->second.slot_size_];
+  *static_cast<void **>(storage) = free_slot;
+  free_slot = storage;
+}
+
+/**
+ * @brief Gets the size of the arena slot a metaobject is stored in, must be invoked while holding
+ * the mutex of the arena
+ */
+size_t getMetaObjectSlotSize(MetaObjectArena & arena, const AbstractMetaObjectBase * meta_obj)
+{
+  auto slab_itr = arena.slabs_.upper_bound(reinterpret_cast<uintptr_t>(meta_obj));
+  return slab_itr == arena.slabs_.end() ? 0 : slab_itr->second.slot_size_;
+}
+
+// Note: Estimated bookkeeping of a node of std::map or std::unordered_map, i.e. its links and
+// color or hash and the allocation header
+const size_t kContainerNodeBytes = 4 * sizeof(void *);
+
+size_t getStringHeapBytes(const std::string & str)
+{
+  // Note: Short strings are stored within the object
+  return str.capacity() < sizeof(std::string) ? 0 : str.capacity() + 1;
+}
+
+#ifdef __linux__
+/**
+ * @brief The loaded object to measure (@see getMappedLibrarySize()), by load address, and the
+ * size of its loadable segments
+ */
+struct MeasuredObject
+{
+  ElfW(Addr) address;
+  size_t num_bytes;
+};
+
+int measureObject(struct dl_phdr_info * info, size_t, void * data)
+{
+  MeasuredObject * object = static_cast<MeasuredObject *>(data);
+  if (info->dlpi_addr != object->address) {
+    return 0;
+  }
+  const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr) & segment = info->dlpi_phdr[i];
+    if (PT_LOAD == segment.p_type) {
+      uintptr_t begin = (info->dlpi_addr + segment.p_vaddr) & ~(page_size - 1);
+      uintptr_t end = info->dlpi_addr + segment.p_vaddr + segment.p_memsz;
+      object->num_bytes += (end - begin + page_size - 1) & ~(page_size - 1);
+    }
+  }
+  return 1;
+}
+#endif
+
+size_t getMappedLibrarySize(const std::string & library_path)
+{
+#ifdef __linux__
+  // Note: The handle also keeps the library mapped while it is measured
+  void * handle = dlopen(library_path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+  if (nullptr == handle) {
+    return 0;
+  }
+  MeasuredObject object = {0, 0};
+  struct link_map * link_map = nullptr;
+  if (0 == dlinfo(handle, RTLD_DI_LINKMAP, &link_map) && nullptr != link_map) {
+    object.address = link_map->l_addr;
+    dl_iterate_phdr(measureObject, &object);
+  }
+  dlclose(handle);
+  return object.num_bytes;
+#else
+  static_cast<void>(library_path);
+  return 0;
+#endif
+}
+
+MemoryUsage getMemoryUsage()
+{
+  MemoryUsage usage = MemoryUsage();
+  std::vector<std::string> library_paths;
+  {
     boost::recursive_mutex::scoped_lock lock(getLoadedLibraryVectorMutex());
-    LibraryVector & open_libraries = getLoadedLibraryVector();
-    LibraryVector::iterator itr = findLoadedLibrary(library_path);
-    if (itr != open_libraries.end()) {
-      Poco::SharedLibrary * library = itr->second;
-      std::string library_path = itr->first;
-      try {
-        destroyMetaObjectsForLibrary(library_path, loader);
-
-        // Remove from loaded library list as well if no more factories associated with said library
-        if (!areThereAnyExistingMetaObjectsForLibrary(library_path)) {
-          CONSOLE_BRIDGE_logDebug(
-            "class_loader.impl: "
-            "There are no more MetaObjects left for %s so unloading library and "
-            "removing from loaded library vector.\n",
-            library_path.c_str());
-          library->unload();
-          assert(library->isLoaded() == false);
-          delete (library);
-          itr = open_libraries.erase(itr);
-        } else {
-          CONSOLE_BRIDGE_logDebug(
-            "class_loader.impl: "
-            "MetaObjects still remain in memory meaning other ClassLoaders are still using library"
-            ", keeping library %s open.",
-            library_path.c_str());
+    for (auto & it : getLoadedLibraryMap()) {
+      library_paths.push_back(getSymbolName(it.first));
+    }
+  }
+  usage.loaded_library_count = library_paths.size();
+  for (auto & library_path : library_paths) {
+    usage.mapped_library_bytes += getMappedLibrarySize(library_path);
+  }
+
+  {
+    boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+    MetaObjectArena & arena = getMetaObjectArena();
+    {
+      boost::mutex::scoped_lock arena_lock(arena.mutex_);
+      usage.arena_bytes = arena.bytes_reserved_;
+      // Note: The index holds the registered metaobjects, including those of staged libraries
+      for (auto & library_it : getMetaObjectIndex().meta_objects_by_library_) {
+        for (auto & meta_obj : library_it.second) {
+          ++usage.meta_object_count;
+          usage.meta_object_bytes +=
+            getMetaObjectSlotSize(arena, meta_obj) + meta_obj->getDynamicMemoryUsage();
         }
-        return;
-      } catch (const Poco::RuntimeException & e) {
-        delete (library);
-        throw class_loader::LibraryUnloadException(
-                "Could not unload library (Poco exception = " + std::string(e.message()) + ")");
       }
+      for (auto & library_it : getMetaObjectGraveyard()) {
+        usage.graveyard_bytes += sizeof(MetaObjectGraveyard::value_type) + kContainerNodeBytes +
+          library_it.second.capacity() * sizeof(AbstractMetaObjectBase *);
+        for (auto & meta_obj : library_it.second) {
+          ++usage.graveyard_meta_object_count;
+          usage.graveyard_bytes +=
+            getMetaObjectSlotSize(arena, meta_obj) + meta_obj->getDynamicMemoryUsage();
+        }
+      }
+    }
+
+    for (auto & base_it : getGlobalPluginBaseToFactoryMapMap()) {
+      usage.registry_bytes += sizeof(BaseToFactoryMapMap::value_type) + kContainerNodeBytes +
+        base_it.second.size() * (sizeof(FactoryMap::value_type) + kContainerNodeBytes);
+    }
+    MetaObjectIndex & index = getMetaObjectIndex();
+    for (auto & library_it : index.meta_objects_by_library_) {
+      usage.registry_bytes += sizeof(library_it) + kContainerNodeBytes +
+        library_it.second.capacity() * sizeof(AbstractMetaObjectBase *);
+    }
+    for (auto & loader_it : index.owned_counts_by_loader_) {
+      usage.registry_bytes += sizeof(loader_it) + kContainerNodeBytes +
+        loader_it.second.size() * (sizeof(std::pair<SymbolId, size_t>) + kContainerNodeBytes);
+    }
+    for (size_t i = 0; i < kNumFactoryShards; ++i) {
+      FactoryShard & shard = getFactoryShards()[i];
+      boost::mutex::scoped_lock shard_lock(shard.mutex_);
+      usage.registry_bytes +=
+        shard.factory_maps_.capacity() * sizeof(std::pair<SymbolId, const FactoryMap *>);
+      if (shard.index_) {
+        usage.registry_bytes += sizeof(FactoryIndex) +
+          shard.index_->factories_.bucket_count() * sizeof(void *) +
+          shard.index_->factories_.size() *
+          (sizeof(FactoryIndexMap::value_type) + kContainerNodeBytes);
+      }
+    }
+  }
+
+  SymbolTable & table = getSymbolTable();
+  boost::mutex::scoped_lock lock(table.mutex_);
+  // Note: Every name is stored twice, as the key of its ID and by the ID
+  usage.symbol_count = table.size_ - 1;
+  usage.symbol_bytes = table.ids_.bucket_count() * sizeof(void *);
+  for (SymbolId id = 0; id < table.size_; ++id) {
+    const std::string & name = table.getName(id);
+    usage.symbol_bytes += 2 * (sizeof(std::string) + getStringHeapBytes(name)) +
+      sizeof(SymbolId) + kContainerNodeBytes;
+  }
+  for (size_t chunk = 0; chunk < kNumSymbolChunks; ++chunk) {
+    if (nullptr != table.chunks_[chunk].load(std::memory_order_relaxed)) {
+      usage.symbol_bytes += (kFirstSymbolChunkSize << chunk) * sizeof(std::string);
     }
-    throw class_loader::LibraryUnloadException(
-            "Attempt to unload library that class_loader is unaware of.");
   }
+  // Note: The slots of the names are counted with the chunks
+  usage.symbol_bytes -= table.size_ * sizeof(std::string);
+  return usage;
 }
 
 
@@ -573,11 +2486,11 @@ void printDebugInfoToScreen()
   printf("OPEN LIBRARIES IN MEMORY:\n");
   printf("--------------------------------------------------------------------------------\n");
   boost::recursive_mutex::scoped_lock lock(getLoadedLibraryVectorMutex());
-  LibraryVector libs = getLoadedLibraryVector();
-  for (size_t c = 0; c < libs.size(); c++) {
+  size_t c = 0;
+  for (auto & it : getLoadedLibraryMap()) {
     printf(
-      "Open library %zu = %s (Poco SharedLibrary handle = %p)\n",
-      c, (libs.at(c)).first.c_str(), reinterpret_cast<void *>((libs.at(c)).second));
+      "Open library %zu = %s (handle = %p, flags = %d)\n",
+      c++, getSymbolName(it.first).c_str(), it.second.handle, it.second.flags);
   }
 
   printf("METAOBJECTS (i.e. FACTORIES) IN MEMORY:\n");
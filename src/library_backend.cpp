@@ -0,0 +1,185 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "class_loader/library_backend.hpp"
+
+#ifdef CLASS_LOADER_USE_POCO
+#include <Poco/SharedLibrary.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include <atomic>
+#include <string>
+
+#include "class_loader/exceptions.hpp"
+
+namespace class_loader
+{
+namespace impl
+{
+
+LibraryBackend::~LibraryBackend()
+{
+}
+
+/**
+ * @class NativeLibraryBackend
+ * @brief Opens libraries with dlopen(), or LoadLibrary() on Windows
+ */
+class NativeLibraryBackend : public LibraryBackend
+{
+public:
+  LibraryHandle open(const std::string & library_path, int flags)
+  {
+#ifdef _WIN32
+    // Note: LoadLibrary() always binds eagerly and has no notion of symbol visibility
+    (void)flags;
+    HMODULE handle = LoadLibraryA(library_path.c_str());
+    if (nullptr == handle) {
+      throw class_loader::LibraryLoadException(
+              "Could not load library " + library_path +
+              " (error code = " + std::to_string(GetLastError()) + ")");
+    }
+    return reinterpret_cast<LibraryHandle>(handle);
+#else
+    int dlopen_flags = (flags & LIBRARY_LOAD_NOW) ? RTLD_NOW : RTLD_LAZY;
+    dlopen_flags |= (flags & LIBRARY_LOAD_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+#ifdef RTLD_NODELETE
+    if (flags & LIBRARY_LOAD_NODELETE) {
+      dlopen_flags |= RTLD_NODELETE;
+    }
+#endif
+#ifdef RTLD_DEEPBIND
+    if (flags & LIBRARY_LOAD_DEEPBIND) {
+      dlopen_flags |= RTLD_DEEPBIND;
+    }
+#endif
+    void * handle = dlopen(library_path.c_str(), dlopen_flags);
+    if (nullptr == handle) {
+      const char * error = dlerror();
+      throw class_loader::LibraryLoadException(
+              "Could not load library (dlopen error = " +
+              std::string(nullptr != error ? error : library_path) + ")");
+    }
+    return handle;
+#endif
+  }
+
+  void close(LibraryHandle handle)
+  {
+#ifdef _WIN32
+    if (!FreeLibrary(reinterpret_cast<HMODULE>(handle))) {
+      throw class_loader::LibraryUnloadException(
+              "Could not unload library (error code = " + std::to_string(GetLastError()) + ")");
+    }
+#else
+    if (0 != dlclose(handle)) {
+      const char * error = dlerror();
+      throw class_loader::LibraryUnloadException(
+              "Could not unload library (dlclose error = " +
+              std::string(nullptr != error ? error : "unknown") + ")");
+    }
+#endif
+  }
+};
+
+LibraryBackend & getNativeLibraryBackend()
+{
+  // Note: Leaked, so that libraries can still be closed by static destructors
+  static NativeLibraryBackend * instance = new NativeLibraryBackend();
+  return *instance;
+}
+
+#ifdef CLASS_LOADER_USE_POCO
+/**
+ * @class PocoLibraryBackend
+ * @brief Opens libraries with Poco::SharedLibrary, which only supports LIBRARY_LOAD_LOCAL
+ */
+class PocoLibraryBackend : public LibraryBackend
+{
+public:
+  LibraryHandle open(const std::string & library_path, int flags)
+  {
+    try {
+      return new Poco::SharedLibrary(
+        library_path, (flags & LIBRARY_LOAD_LOCAL) ? Poco::SharedLibrary::SHLIB_LOCAL : 0);
+    } catch (const Poco::LibraryLoadException & e) {
+      throw class_loader::LibraryLoadException(
+              "Could not load library (Poco exception = " + std::string(e.message()) + ")");
+    } catch (const Poco::LibraryAlreadyLoadedException & e) {
+      throw class_loader::LibraryLoadException(
+              "Library already loaded (Poco exception = " + std::string(e.message()) + ")");
+    } catch (const Poco::NotFoundException & e) {
+      throw class_loader::LibraryLoadException(
+              "Library not found (Poco exception = " + std::string(e.message()) + ")");
+    }
+  }
+
+  void close(LibraryHandle handle)
+  {
+    Poco::SharedLibrary * library = static_cast<Poco::SharedLibrary *>(handle);
+    try {
+      library->unload();
+    } catch (const Poco::RuntimeException & e) {
+      delete (library);
+      throw class_loader::LibraryUnloadException(
+              "Could not unload library (Poco exception = " + std::string(e.message()) + ")");
+    }
+    delete (library);
+  }
+};
+#endif
+
+std::atomic<LibraryBackend *> & getLibraryBackendReference()
+{
+#ifdef CLASS_LOADER_USE_POCO
+  static std::atomic<LibraryBackend *> instance(new PocoLibraryBackend());
+#else
+  static std::atomic<LibraryBackend *> instance(&getNativeLibraryBackend());
+#endif
+  return instance;
+}
+
+LibraryBackend & getLibraryBackend()
+{
+  return *getLibraryBackendReference().load(std::memory_order_acquire);
+}
+
+void setLibraryBackend(LibraryBackend & backend)
+{
+  getLibraryBackendReference().store(&backend, std::memory_order_release);
+}
+
+}  // namespace impl
+}  // namespace class_loader
@@ -27,6 +27,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <memory>
 #include <string>
 
 #include "class_loader/meta_object.hpp"
@@ -37,14 +39,39 @@ namespace class_loader
 namespace impl
 {
 
+/**
+ * @brief The bits of the owner IDs from 64 on, 64 per word
+ */
+struct AbstractMetaObjectBase::OwnerBitWords
+{
+  explicit OwnerBitWords(size_t size)
+  : size_(size), words_(new std::atomic<uint64_t>[size])
+  {
+    for (size_t i = 0; i < size; ++i) {
+      words_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  size_t size_;
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+};
+
 AbstractMetaObjectBase::AbstractMetaObjectBase(
   const std::string & class_name, const std::string & base_class_name)
-: associated_library_path_("Unknown"),
-  base_class_name_(base_class_name),
-  class_name_(class_name),
-  typeid_base_class_name_("UNSET")
+: inline_owner_bits_(0),
+  overflow_owner_bits_(nullptr),
+  associated_library_path_(&getSymbolName(internSymbol("Unknown"))),
+  base_class_name_(&getSymbolName(internSymbol(base_class_name))),
+  class_name_(nullptr),
+  typeid_base_class_name_(&getSymbolName(internSymbol("UNSET"))),
+  associated_library_id_(internSymbol(*associated_library_path_)),
+  class_id_(internSymbol(class_name)),
+  typeid_base_class_id_(kInvalidSymbolId),
+  creation_count_(0),
+  destruction_count_(0)
 {
-  CONSOLE_BRIDGE_logDebug(
+  class_name_ = &getSymbolName(class_id_);
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.impl.AbstractMetaObjectBase: "
     "Creating MetaObject %p (base = %s, derived = %s, library path = %s)",
     this, baseClassName().c_str(), className().c_str(), getAssociatedLibraryPath().c_str());
@@ -52,59 +79,138 @@ AbstractMetaObjectBase::AbstractMetaObjectBase(
 
 AbstractMetaObjectBase::~AbstractMetaObjectBase()
 {
-  CONSOLE_BRIDGE_logDebug(
+  CLASS_LOADER_LOG_DEBUG(
     "class_loader.impl.AbstractMetaObjectBase: "
     "Destroying MetaObject %p (base = %s, derived = %s, library path = %s)",
     this, baseClassName().c_str(), className().c_str(), getAssociatedLibraryPath().c_str());
 }
 
-std::string AbstractMetaObjectBase::className() const
+const std::string & AbstractMetaObjectBase::className() const
+{
+  return *class_name_;
+}
+
+SymbolId AbstractMetaObjectBase::classId() const
+{
+  return class_id_;
+}
+
+const std::string & AbstractMetaObjectBase::baseClassName() const
+{
+  return *base_class_name_;
+}
+
+const std::string & AbstractMetaObjectBase::typeidBaseClassName() const
+{
+  return *typeid_base_class_name_;
+}
+
+SymbolId AbstractMetaObjectBase::typeidBaseClassId() const
 {
-  return class_name_;
+  return typeid_base_class_id_;
 }
 
-std::string AbstractMetaObjectBase::baseClassName() const
+void AbstractMetaObjectBase::setTypeidBaseClassName(const std::string & typeid_base_class_name)
 {
-  return base_class_name_;
+  typeid_base_class_id_ = internSymbol(typeid_base_class_name);
+  typeid_base_class_name_ = &getSymbolName(typeid_base_class_id_);
 }
 
-std::string AbstractMetaObjectBase::typeidBaseClassName() const
+const std::string & AbstractMetaObjectBase::getAssociatedLibraryPath() const
 {
-  return typeid_base_class_name_;
+  return *associated_library_path_;
 }
 
-std::string AbstractMetaObjectBase::getAssociatedLibraryPath()
+SymbolId AbstractMetaObjectBase::associatedLibraryId() const
 {
-  return associated_library_path_;
+  return associated_library_id_;
 }
 
 void AbstractMetaObjectBase::setAssociatedLibraryPath(std::string library_path)
 {
-  associated_library_path_ = library_path;
+  associated_library_id_ = internSymbol(library_path);
+  associated_library_path_ = &getSymbolName(associated_library_id_);
+}
+
+size_t AbstractMetaObjectBase::getOwnerId(const ClassLoader * loader)
+{
+  return nullptr == loader ? 0 : loader->owner_id_;
+}
+
+void AbstractMetaObjectBase::setOwnerBit(size_t owner_id, bool owned)
+{
+  if (owner_id < 64) {
+    uint64_t bit = static_cast<uint64_t>(1) << owner_id;
+    if (owned) {
+      inline_owner_bits_.fetch_or(bit, std::memory_order_release);
+    } else {
+      inline_owner_bits_.fetch_and(~bit, std::memory_order_release);
+    }
+    return;
+  }
+
+  boost::recursive_mutex::scoped_lock lock(getPluginBaseToFactoryMapMapMutex());
+  size_t word = owner_id / 64 - 1;
+  uint64_t bit = static_cast<uint64_t>(1) << (owner_id % 64);
+  const OwnerBitWords * words = overflow_owner_bits_.load(std::memory_order_relaxed);
+  if (nullptr == words || words->size_ <= word) {
+    if (!owned) {
+      return;
+    }
+    // Note: Doubling the size bounds the replaced arrays to the size of the current one
+    size_t size = std::max(word + 1, nullptr == words ? 0 : 2 * words->size_);
+    std::unique_ptr<OwnerBitWords> grown(new OwnerBitWords(size));
+    for (size_t i = 0; nullptr != words && i < words->size_; ++i) {
+      grown->words_[i].store(words->words_[i].load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    }
+    words = grown.get();
+    overflow_owner_bit_arrays_.push_back(std::move(grown));
+    overflow_owner_bits_.store(words, std::memory_order_release);
+  }
+  if (owned) {
+    words->words_[word].fetch_or(bit, std::memory_order_release);
+  } else {
+    words->words_[word].fetch_and(~bit, std::memory_order_release);
+  }
+}
+
+bool AbstractMetaObjectBase::testOwnerBit(size_t owner_id) const
+{
+  if (owner_id < 64) {
+    uint64_t bit = static_cast<uint64_t>(1) << owner_id;
+    return 0 != (inline_owner_bits_.load(std::memory_order_acquire) & bit);
+  }
+
+  size_t word = owner_id / 64 - 1;
+  uint64_t bit = static_cast<uint64_t>(1) << (owner_id % 64);
+  const OwnerBitWords * words = overflow_owner_bits_.load(std::memory_order_acquire);
+  return nullptr != words && word < words->size_ &&
+         0 != (words->words_[word].load(std::memory_order_acquire) & bit);
 }
 
 void AbstractMetaObjectBase::addOwningClassLoader(ClassLoader * loader)
 {
-  ClassLoaderVector & v = associated_class_loaders_;
-  if (std::find(v.begin(), v.end(), loader) == v.end()) {
-    v.push_back(loader);
+  size_t owner_id = getOwnerId(loader);
+  if (!testOwnerBit(owner_id)) {
+    associated_class_loaders_.push_back(loader);
+    setOwnerBit(owner_id, true);
   }
 }
 
 void AbstractMetaObjectBase::removeOwningClassLoader(const ClassLoader * loader)
 {
-  ClassLoaderVector & v = associated_class_loaders_;
-  ClassLoaderVector::iterator itr = std::find(v.begin(), v.end(), loader);
-  if (itr != v.end()) {
-    v.erase(itr);
+  size_t owner_id = getOwnerId(loader);
+  if (testOwnerBit(owner_id)) {
+    setOwnerBit(owner_id, false);
+    ClassLoaderVector & v = associated_class_loaders_;
+    v.erase(std::find(v.begin(), v.end(), loader));
   }
 }
 
 bool AbstractMetaObjectBase::isOwnedBy(const ClassLoader * loader)
 {
-  ClassLoaderVector & v = associated_class_loaders_;
-  ClassLoaderVector::iterator itr = std::find(v.begin(), v.end(), loader);
-  return itr != v.end();
+  return testOwnerBit(getOwnerId(loader));
 }
 
 bool AbstractMetaObjectBase::isOwnedByAnybody()
@@ -117,5 +223,41 @@ ClassLoaderVector AbstractMetaObjectBase::getAssociatedClassLoaders()
   return associated_class_loaders_;
 }
 
+size_t AbstractMetaObjectBase::getCreationCount() const
+{
+  return creation_count_.load(std::memory_order_relaxed);
+}
+
+size_t AbstractMetaObjectBase::getDestructionCount() const
+{
+  return destruction_count_.load(std::memory_order_relaxed);
+}
+
+void AbstractMetaObjectBase::resetCounts()
+{
+  creation_count_.store(0, std::memory_order_relaxed);
+  destruction_count_.store(0, std::memory_order_relaxed);
+}
+
+size_t AbstractMetaObjectBase::getDynamicMemoryUsage() const
+{
+  size_t usage = associated_class_loaders_.capacity() * sizeof(ClassLoader *) +
+    overflow_owner_bit_arrays_.capacity() * sizeof(std::unique_ptr<OwnerBitWords>);
+  for (auto & words : overflow_owner_bit_arrays_) {
+    usage += sizeof(OwnerBitWords) + words->size_ * sizeof(std::atomic<uint64_t>);
+  }
+  return usage;
+}
+
+void * AbstractMetaObjectBase::operator new(size_t size)
+{
+  return allocateMetaObjectStorage(size);
+}
+
+void AbstractMetaObjectBase::operator delete(void * storage)
+{
+  freeMetaObjectStorage(storage);
+}
+
 }  // namespace impl
 }  // namespace class_loader
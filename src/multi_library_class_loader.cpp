@@ -29,15 +29,38 @@
 
 #include "class_loader/multi_library_class_loader.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace class_loader
 {
 
-MultiLibraryClassLoader::MultiLibraryClassLoader(bool enable_ondemand_loadunload)
-: enable_ondemand_loadunload_(enable_ondemand_loadunload)
+/**
+ * @brief Keeps a class loader from ever being destroyed, as instances whose deleters refer to it may still exist
+ */
+void leakClassLoader(std::shared_ptr<ClassLoader> loader)
+{
+  // Note: Never destroyed, so that the class loaders stay reachable
+  static boost::mutex * mutex = new boost::mutex();
+  static std::vector<std::shared_ptr<ClassLoader>> * loaders =
+    new std::vector<std::shared_ptr<ClassLoader>>();
+  boost::mutex::scoped_lock lock(*mutex);
+  loaders->push_back(std::move(loader));
+}
+
+MultiLibraryClassLoader::MultiLibraryClassLoader(bool enable_ondemand_loadunload, int load_flags)
+: enable_ondemand_loadunload_(enable_ondemand_loadunload),
+  load_flags_(load_flags)
 {
 }
 
@@ -48,6 +71,7 @@ MultiLibraryClassLoader::~MultiLibraryClassLoader()
 
 std::vector<std::string> MultiLibraryClassLoader::getRegisteredLibraries()
 {
+  boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
   std::vector<std::string> libraries;
   for (auto & it : active_class_loaders_) {
     if (it.second != nullptr) {
@@ -65,6 +89,32 @@ ClassLoader * MultiLibraryClassLoader::getClassLoaderForLibrary(const std::strin
   } else {return nullptr;}
 }
 
+std::shared_ptr<ClassLoader> MultiLibraryClassLoader::shareClassLoader(ClassLoader * loader)
+{
+  auto itr = class_loader_owners_.find(loader);
+  return itr == class_loader_owners_.end() ? nullptr : itr->second;
+}
+
+std::shared_ptr<ClassLoader> MultiLibraryClassLoader::shareClassLoaderForLibrary(
+  const std::string & library_path)
+{
+  boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
+  return shareClassLoader(getClassLoaderForLibrary(library_path));
+}
+
+void MultiLibraryClassLoader::registerClassLoader(
+  const std::string & library_path, ClassLoader * loader)
+{
+  active_class_loaders_[library_path] = loader;
+  class_loader_owners_[loader] = std::shared_ptr<ClassLoader>(
+    loader, [library_path](ClassLoader * owned_loader) {
+      destroyClassLoader(library_path, owned_loader);
+    });
+  if (loader->isLibraryLoaded()) {
+    indexClassLoader(loader);
+  }
+}
+
 ClassLoaderVector MultiLibraryClassLoader::getAllAvailableClassLoaders()
 {
   ClassLoaderVector loaders;
@@ -76,15 +126,342 @@ ClassLoaderVector MultiLibraryClassLoader::getAllAvailableClassLoaders()
 
 bool MultiLibraryClassLoader::isLibraryAvailable(const std::string & library_name)
 {
+  boost::shared_lock<boost::shared_mutex> lock(loader_mutex_);
   return getClassLoaderForLibrary(library_name) != nullptr;
 }
 
+ClassLoader * MultiLibraryClassLoader::getIndexedClassLoaderForClass(
+  impl::SymbolId typeid_base_class_id, const std::string & class_name)
+{
+  BaseToClassToClassLoaderMap::iterator base_itr = class_loader_index_.find(typeid_base_class_id);
+  if (base_itr == class_loader_index_.end()) {
+    return nullptr;
+  }
+  ClassToClassLoaderMap::iterator class_itr =
+    base_itr->second.find(class_loader::impl::findSymbol(class_name));
+  if (class_itr == base_itr->second.end()) {
+    return nullptr;
+  }
+  return class_itr->second;
+}
+
+bool MultiLibraryClassLoader::isClassLoaderIndexed(ClassLoader * loader)
+{
+  return indexed_class_loaders_.count(loader) > 0;
+}
+
+void MultiLibraryClassLoader::indexClassLoader(ClassLoader * loader)
+{
+  for (auto & it : class_loader::impl::getRegisteredClassesForLibrary(
+      loader->getLibraryPath(), loader))
+  {
+    class_loader_index_[it.first].insert(std::make_pair(it.second, loader));
+  }
+  indexed_class_loaders_.insert(loader);
+}
+
+void MultiLibraryClassLoader::unindexClassLoader(ClassLoader * loader)
+{
+  for (auto & base_it : class_loader_index_) {
+    ClassToClassLoaderMap & classes = base_it.second;
+    for (auto class_itr = classes.begin(); class_itr != classes.end(); ) {
+      if (class_itr->second == loader) {
+        class_itr = classes.erase(class_itr);
+      } else {
+        ++class_itr;
+      }
+    }
+  }
+  indexed_class_loaders_.erase(loader);
+}
+
 void MultiLibraryClassLoader::loadLibrary(const std::string & library_path)
 {
-  if (!isLibraryAvailable(library_path)) {
-    active_class_loaders_[library_path] =
-      new class_loader::ClassLoader(library_path, isOnDemandLoadUnloadEnabled());
+  if (isLibraryAvailable(library_path)) {
+    return;
+  }
+
+  // Note: The library is opened without holding the lock, so that instances of the classes
+  // of other libraries can be created meanwhile
+  ClassLoader * loader =
+    new class_loader::ClassLoader(library_path, isOnDemandLoadUnloadEnabled(), load_flags_);
+  boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+  if (nullptr != getClassLoaderForLibrary(library_path)) {
+    // Another thread loaded the library in the meantime
+    lock.unlock();
+    delete (loader);
+    return;
+  }
+  registerClassLoader(library_path, loader);
+}
+
+void MultiLibraryClassLoader::loadLibraries(const std::vector<std::string> & library_paths)
+{
+  std::vector<std::string> pending_paths;
+  for (auto & library_path : library_paths) {
+    if (!isLibraryAvailable(library_path) &&
+      std::find(pending_paths.begin(), pending_paths.end(), library_path) == pending_paths.end())
+    {
+      pending_paths.push_back(library_path);
+    }
+  }
+
+  std::vector<ClassLoader *> loaders(pending_paths.size(), nullptr);
+  std::vector<std::exception_ptr> errors(pending_paths.size());
+  std::atomic<size_t> next_path(0);
+  auto load_pending_paths = [&]() {
+      for (size_t i = next_path++; i < pending_paths.size(); i = next_path++) {
+        try {
+          loaders[i] = new class_loader::ClassLoader(
+            pending_paths[i], isOnDemandLoadUnloadEnabled(), load_flags_);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      }
+    };
+
+  size_t num_workers = std::min<size_t>(
+    pending_paths.size(), std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers; ++i) {
+    workers.emplace_back(load_pending_paths);
+  }
+  load_pending_paths();
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  // Register the results in order, as if the libraries had been loaded one after the other
+  std::exception_ptr error;
+  std::vector<ClassLoader *> unused_loaders;
+  {
+    boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+    for (size_t i = 0; i < pending_paths.size(); ++i) {
+      if (!error && errors[i]) {
+        error = errors[i];
+      } else if (!error && nullptr == getClassLoaderForLibrary(pending_paths[i])) {
+        registerClassLoader(pending_paths[i], loaders[i]);
+      } else if (nullptr != loaders[i]) {
+        // Past the failure, or loaded by another thread in the meantime
+        unused_loaders.push_back(loaders[i]);
+      }
+    }
+  }
+  for (auto & loader : unused_loaders) {
+    delete (loader);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+LibraryLoadReport MultiLibraryClassLoader::loadLibrariesInDependencyOrder(
+  const std::vector<std::string> & library_paths, const LibraryDependencyMap & dependencies,
+  size_t num_threads)
+{
+  auto load_start = std::chrono::steady_clock::now();
+  auto elapsed_ns = [&]() {
+      return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - load_start).count());
+    };
+
+  std::vector<std::string> pending_paths;
+  std::unordered_map<std::string, size_t> indices_by_name;
+  for (auto & library_path : library_paths) {
+    if (!isLibraryAvailable(library_path) && 0 == indices_by_name.count(library_path)) {
+      indices_by_name[library_path] = pending_paths.size();
+      pending_paths.push_back(library_path);
+    }
+  }
+  // Needed libraries are recorded by file name, paths take precedence over file names though
+  for (size_t i = 0; i < pending_paths.size(); ++i) {
+    size_t separator = pending_paths[i].find_last_of('/');
+    if (separator != std::string::npos) {
+      indices_by_name.insert(std::make_pair(pending_paths[i].substr(separator + 1), i));
+    }
+  }
+
+  // Build the dependency graph of the libraries to load
+  const size_t num_libraries = pending_paths.size();
+  std::vector<std::vector<size_t>> dependency_indices(num_libraries);
+  std::vector<std::vector<size_t>> dependent_indices(num_libraries);
+  for (size_t i = 0; i < num_libraries; ++i) {
+    std::vector<std::string> names = impl::getNeededLibraries(pending_paths[i]);
+    auto declared = dependencies.find(pending_paths[i]);
+    if (declared != dependencies.end()) {
+      names.insert(names.end(), declared->second.begin(), declared->second.end());
+    }
+    for (auto & name : names) {
+      auto found = indices_by_name.find(name);
+      if (found == indices_by_name.end() || found->second == i ||
+        std::find(dependency_indices[i].begin(), dependency_indices[i].end(), found->second) !=
+        dependency_indices[i].end())
+      {
+        continue;
+      }
+      dependency_indices[i].push_back(found->second);
+      dependent_indices[found->second].push_back(i);
+    }
+  }
+
+  // Check that the graph is acyclic before loading anything
+  std::vector<size_t> remaining_dependencies(num_libraries);
+  std::deque<size_t> ready;
+  for (size_t i = 0; i < num_libraries; ++i) {
+    remaining_dependencies[i] = dependency_indices[i].size();
+    if (0 == remaining_dependencies[i]) {
+      ready.push_back(i);
+    }
+  }
+  {
+    std::vector<size_t> counts = remaining_dependencies;
+    std::deque<size_t> queue = ready;
+    size_t num_sorted = 0;
+    for (; !queue.empty(); queue.pop_front(), ++num_sorted) {
+      for (auto dependent : dependent_indices[queue.front()]) {
+        if (0 == --counts[dependent]) {
+          queue.push_back(dependent);
+        }
+      }
+    }
+    if (num_sorted < num_libraries) {
+      std::string cycle;
+      for (size_t i = 0; i < num_libraries; ++i) {
+        if (0 != counts[i]) {
+          cycle += (cycle.empty() ? "" : ", ") + pending_paths[i];
+        }
+      }
+      throw class_loader::LibraryLoadException(
+              "Could not load libraries, there are cyclic dependencies between " + cycle);
+    }
+  }
+
+  // Load the libraries as their dependencies get loaded, stopping at the first failure
+  std::vector<ClassLoader *> loaders(num_libraries, nullptr);
+  std::vector<uint64_t> start_times_ns(num_libraries, 0);
+  std::vector<uint64_t> finish_times_ns(num_libraries, 0);
+  std::vector<size_t> start_order;
+  std::exception_ptr error;
+  size_t num_running = 0;
+  boost::mutex mutex;
+  boost::condition_variable condition;
+  auto load_ready_libraries = [&]() {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      for (;;) {
+        while (ready.empty() && !error && num_running > 0) {
+          condition.wait(lock);
+        }
+        if (ready.empty() || error) {
+          return;
+        }
+        size_t i = ready.front();
+        ready.pop_front();
+        ++num_running;
+        start_order.push_back(i);
+        start_times_ns[i] = elapsed_ns();
+        lock.unlock();
+
+        ClassLoader * loader = nullptr;
+        std::exception_ptr load_error;
+        try {
+          loader = new class_loader::ClassLoader(
+            pending_paths[i], isOnDemandLoadUnloadEnabled(), load_flags_);
+        } catch (...) {
+          load_error = std::current_exception();
+        }
+
+        lock.lock();
+        --num_running;
+        finish_times_ns[i] = elapsed_ns();
+        loaders[i] = loader;
+        if (load_error) {
+          if (!error) {
+            error = load_error;
+          }
+        } else {
+          for (auto dependent : dependent_indices[i]) {
+            if (0 == --remaining_dependencies[dependent]) {
+              ready.push_back(dependent);
+            }
+          }
+        }
+        condition.notify_all();
+      }
+    };
+
+  if (0 == num_threads) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, num_libraries);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_threads; ++i) {
+    workers.emplace_back(load_ready_libraries);
   }
+  load_ready_libraries();
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  std::vector<ClassLoader *> unused_loaders;
+  {
+    boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+    for (auto i : start_order) {
+      if (nullptr == loaders[i]) {
+        continue;
+      }
+      if (nullptr == getClassLoaderForLibrary(pending_paths[i])) {
+        registerClassLoader(pending_paths[i], loaders[i]);
+      } else {
+        // Loaded by another thread in the meantime
+        unused_loaders.push_back(loaders[i]);
+      }
+    }
+  }
+  for (auto & loader : unused_loaders) {
+    delete (loader);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  // Libraries start after their dependencies finished, so the start order is a topological order
+  LibraryLoadReport report;
+  report.critical_path_time_ns = 0;
+  report.total_time_ns = elapsed_ns();
+  std::vector<uint64_t> path_times_ns(num_libraries, 0);
+  std::vector<size_t> path_predecessors(num_libraries, num_libraries);
+  size_t path_end = num_libraries;
+  for (auto i : start_order) {
+    LibraryLoadReport::Library library;
+    library.library_path = pending_paths[i];
+    library.start_time_ns = start_times_ns[i];
+    library.finish_time_ns = finish_times_ns[i];
+    for (auto dependency : dependency_indices[i]) {
+      library.dependencies.push_back(pending_paths[dependency]);
+      if (path_times_ns[dependency] > path_times_ns[i]) {
+        path_times_ns[i] = path_times_ns[dependency];
+        path_predecessors[i] = dependency;
+      }
+    }
+    path_times_ns[i] += finish_times_ns[i] - start_times_ns[i];
+    if (path_end == num_libraries || path_times_ns[i] > path_times_ns[path_end]) {
+      path_end = i;
+    }
+    report.libraries.push_back(library);
+  }
+  for (size_t i = path_end; i != num_libraries; i = path_predecessors[i]) {
+    report.critical_path.insert(report.critical_path.begin(), pending_paths[i]);
+  }
+  if (path_end != num_libraries) {
+    report.critical_path_time_ns = path_times_ns[path_end];
+    CLASS_LOADER_LOG_DEBUG(
+      "class_loader.MultiLibraryClassLoader: Loaded %zu libraries in %llu ns, the critical path "
+      "ending with %s took %llu ns", num_libraries,
+      static_cast<unsigned long long>(report.total_time_ns),
+      pending_paths[path_end].c_str(),
+      static_cast<unsigned long long>(report.critical_path_time_ns));
+  }
+  return report;
 }
 
 void MultiLibraryClassLoader::shutdownAllClassLoaders()
@@ -94,20 +471,137 @@ void MultiLibraryClassLoader::shutdownAllClassLoaders()
   for (auto & library_path : getRegisteredLibraries()) {
     unloadLibrary(library_path);
   }
+  {
+    // Note: The libraries of the remaining class loaders stay loaded for instances which still
+    // exist, destroying the class loaders would leave the deleters of the instances dangling
+    boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+    for (auto & it : class_loader_owners_) {
+      leakClassLoader(std::move(it.second));
+    }
+    class_loader_owners_.clear();
+  }
+  destroyRetiredClassLoaders(true);
+}
+
+void MultiLibraryClassLoader::destroyClassLoader(
+  const std::string & library_path, ClassLoader * loader)
+{
+  std::string bound_library_path = loader->getLibraryPath();
+  delete (loader);
+  if (bound_library_path != library_path) {
+    class_loader::impl::discardLibrarySnapshot(bound_library_path);
+  }
+}
+
+void MultiLibraryClassLoader::destroyRetiredClassLoaders(bool force)
+{
+  std::vector<std::shared_ptr<ClassLoader>> unloaded_loaders;
+  {
+    boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+    auto unloaded = std::partition(
+      retired_class_loaders_.begin(), retired_class_loaders_.end(),
+      [](const std::shared_ptr<ClassLoader> & retired) {
+        return retired->isLibraryLoaded();
+      });
+    unloaded_loaders.assign(unloaded, retired_class_loaders_.end());
+    // Note: Destroying a class loader whose instances still exist would leave their deleters
+    // dangling, it unloads its library on its own once they are gone
+    if (force) {
+      for (auto itr = retired_class_loaders_.begin(); itr != unloaded; ++itr) {
+        leakClassLoader(std::move(*itr));
+      }
+      retired_class_loaders_.clear();
+    } else {
+      retired_class_loaders_.erase(unloaded, retired_class_loaders_.end());
+    }
+  }
+  // Note: The class loaders are destroyed here, after any instance being created with them
 }
 
 int MultiLibraryClassLoader::unloadLibrary(const std::string & library_path)
 {
-  int remaining_unloads = 0;
-  LibraryToClassLoaderMap::iterator itr = active_class_loaders_.find(library_path);
-  if (itr != active_class_loaders_.end()) {
-    ClassLoader * loader = itr->second;
-    if (0 == (remaining_unloads = loader->unloadLibrary())) {
-      delete (loader);
+  std::shared_ptr<ClassLoader> loader = shareClassLoaderForLibrary(library_path);
+  if (nullptr == loader) {
+    return 0;
+  }
+  // Note: Closing the library runs its static destructors, lookups and creations with the class
+  // loaders of other libraries go on meanwhile
+  int remaining_unloads = loader->unloadLibrary();
+  if (0 == remaining_unloads) {
+    boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+    LibraryToClassLoaderMap::iterator itr = active_class_loaders_.find(library_path);
+    if (itr != active_class_loaders_.end() && itr->second == loader.get()) {
+      unindexClassLoader(loader.get());
       active_class_loaders_.erase(itr);
+      class_loader_owners_.erase(loader.get());
     }
   }
+  // Note: The class loader is destroyed here, or after the last instance being created with it
   return remaining_unloads;
 }
 
+void MultiLibraryClassLoader::reloadLibrary(const std::string & library_path, int load_flags)
+{
+  if (!isLibraryAvailable(library_path)) {
+    loadLibrary(library_path);
+    return;
+  }
+  destroyRetiredClassLoaders();
+  std::shared_ptr<ClassLoader> loaded_loader = shareClassLoaderForLibrary(library_path);
+
+  // Note: The runtime loader would hand out the old build again for the same path
+  std::string snapshot_path = class_loader::impl::createLibrarySnapshot(library_path);
+
+  // Note: Unless bound to itself, the new build would run the old code of the symbols it exports
+  if (nullptr != loaded_loader && 0 == ((load_flags_ | load_flags) & LIBRARY_LOAD_DEEPBIND)) {
+    std::vector<std::string> symbols = class_loader::impl::getSymbolsInterposedByLibrary(
+      snapshot_path, loaded_loader->getLibraryPath());
+    if (!symbols.empty()) {
+      class_loader::impl::discardLibrarySnapshot(snapshot_path);
+      std::string names;
+      for (size_t i = 0; i < symbols.size() && i < 3; ++i) {
+        names += (names.empty() ? "" : ", ") + symbols[i];
+      }
+      throw class_loader::LibraryLoadException(
+              "Could not reload library " + library_path + ", its new build exports " +
+              std::to_string(symbols.size()) + " symbol(s) bound to the loaded build (" + names +
+              (symbols.size() > 3 ? ", ..." : "") + "). Build it with hidden symbols, " +
+              "e.g. with class_loader_hide_library_symbols(), or reload it with " +
+              "LIBRARY_LOAD_DEEPBIND.");
+    }
+  }
+  loaded_loader.reset();
+
+  ClassLoader * loader = nullptr;
+  try {
+    class_loader::impl::ScopedStagedRegistration staged_registration;
+    loader = new class_loader::ClassLoader(snapshot_path, false, load_flags_ | load_flags);
+  } catch (...) {
+    class_loader::impl::discardLibrarySnapshot(snapshot_path);
+    throw;
+  }
+
+  std::shared_ptr<ClassLoader> replaced_loader;
+  {
+    boost::unique_lock<boost::shared_mutex> lock(loader_mutex_);
+    class_loader::impl::publishLibraryFactories(snapshot_path);
+    LibraryToClassLoaderMap::iterator itr = active_class_loaders_.find(library_path);
+    if (itr != active_class_loaders_.end()) {
+      replaced_loader = shareClassLoader(itr->second);
+      unindexClassLoader(itr->second);
+      class_loader_owners_.erase(itr->second);
+      retired_class_loaders_.push_back(replaced_loader);
+    }
+    registerClassLoader(library_path, loader);
+  }
+  CLASS_LOADER_LOG_DEBUG(
+    "class_loader.MultiLibraryClassLoader: Reloaded library %s from %s.",
+    library_path.c_str(), snapshot_path.c_str());
+
+  if (nullptr != replaced_loader) {
+    replaced_loader->retireLibrary();
+  }
+  destroyRetiredClassLoaders();
+}
+
 }  // namespace class_loader
@@ -0,0 +1,176 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "class_loader/tracer.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "class_loader/exceptions.hpp"
+
+namespace class_loader
+{
+namespace impl
+{
+
+const char * getTraceEventName(TraceEvent event)
+{
+  switch (event) {
+    case TRACE_LIBRARY_OPEN:
+      return "library_open";
+    case TRACE_LIBRARY_CLOSE:
+      return "library_close";
+    case TRACE_REGISTRATION:
+      return "registration";
+    case TRACE_GRAVEYARD_REVIVE:
+      return "graveyard_revive";
+    case TRACE_GRAVEYARD_PURGE:
+      return "graveyard_purge";
+    case TRACE_INSTANCE_CREATE:
+      return "instance_create";
+    case TRACE_INSTANCE_DESTROY:
+      return "instance_destroy";
+  }
+  return "unknown";
+}
+
+Tracer::~Tracer()
+{
+}
+
+std::atomic<Tracer *> & getTracerReference()
+{
+  static std::atomic<Tracer *> tracer(nullptr);
+  return tracer;
+}
+
+void setTracer(Tracer * tracer)
+{
+  getTracerReference().store(tracer, std::memory_order_release);
+}
+
+// TraceEventFileTracer
+
+uint64_t getTraceProcessId()
+{
+#ifdef _WIN32
+  return GetCurrentProcessId();
+#else
+  return static_cast<uint64_t>(getpid());
+#endif
+}
+
+uint64_t getTraceThreadId()
+{
+#ifdef _WIN32
+  return GetCurrentThreadId();
+#elif defined(SYS_gettid)
+  return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  return std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+}
+
+void writeTraceJsonString(std::ostream & out, const char * str)
+{
+  out << '"';
+  for (; '\0' != *str; ++str) {
+    unsigned char c = static_cast<unsigned char>(*str);
+    if ('"' == c || '\\' == c) {
+      out << '\\' << *str;
+    } else if (c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out << escaped;
+    } else {
+      out << *str;
+    }
+  }
+  out << '"';
+}
+
+TraceEventFileTracer::TraceEventFileTracer(const std::string & path)
+: file_(path.c_str(), std::ios::out | std::ios::trunc), has_events_(false)
+{
+  if (!file_) {
+    throw class_loader::ClassLoaderException("Could not open trace file " + path);
+  }
+  file_ << "[";
+}
+
+TraceEventFileTracer::~TraceEventFileTracer()
+{
+  file_ << "\n]\n";
+}
+
+void TraceEventFileTracer::begin(TraceEvent event, const char * name)
+{
+  write(event, name, 'B');
+}
+
+void TraceEventFileTracer::end(TraceEvent event, const char * name)
+{
+  write(event, name, 'E');
+}
+
+void TraceEventFileTracer::write(TraceEvent event, const char * name, char phase)
+{
+  // Note: Microseconds since the epoch of the steady clock, as the format expects
+  double timestamp_us = std::chrono::duration<double, std::micro>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+  char timestamp[32];
+  snprintf(timestamp, sizeof(timestamp), "%.3f", timestamp_us);
+  uint64_t thread_id = getTraceThreadId();
+
+  boost::mutex::scoped_lock lock(mutex_);
+  file_ << (has_events_ ? ",\n" : "\n") << "{\"name\":\"" << getTraceEventName(event) <<
+    "\",\"cat\":\"class_loader\",\"ph\":\"" << phase << "\",\"ts\":" << timestamp <<
+    ",\"pid\":" << getTraceProcessId() << ",\"tid\":" << thread_id << ",\"args\":{\"name\":";
+  writeTraceJsonString(file_, name);
+  file_ << "}}";
+  has_events_ = true;
+}
+
+}  // namespace impl
+}  // namespace class_loader
@@ -0,0 +1,62 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Synthetic plugin library for the benchmarks. The build compiles this file into several
+// libraries, each with its own BENCHMARK_PLUGIN_LIBRARY_INDEX, and every library registers
+// BENCHMARK_PLUGIN_CLASS_COUNT classes named BenchmarkPlugin<library index>_<class index>.
+
+#include <boost/preprocessor/cat.hpp>
+#include <boost/preprocessor/repetition/repeat.hpp>
+
+#include "class_loader/class_loader.hpp"
+
+#include "./base.hpp"
+
+#ifndef BENCHMARK_PLUGIN_LIBRARY_INDEX
+#error "BENCHMARK_PLUGIN_LIBRARY_INDEX must be defined"
+#endif
+
+#ifndef BENCHMARK_PLUGIN_CLASS_COUNT
+#error "BENCHMARK_PLUGIN_CLASS_COUNT must be defined"
+#endif
+
+#define BENCHMARK_PLUGIN_NAME(n) \
+  BOOST_PP_CAT(BOOST_PP_CAT(BOOST_PP_CAT(BenchmarkPlugin, BENCHMARK_PLUGIN_LIBRARY_INDEX), _), n)
+
+#define BENCHMARK_PLUGIN(z, n, unused) \
+  class BENCHMARK_PLUGIN_NAME(n) : public Base \
+  { \
+public: \
+    virtual void saySomething() {} \
+  }; \
+  CLASS_LOADER_REGISTER_CLASS(BENCHMARK_PLUGIN_NAME(n), Base)
+
+BOOST_PP_REPEAT(BENCHMARK_PLUGIN_CLASS_COUNT, BENCHMARK_PLUGIN, ~)
@@ -0,0 +1,284 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2026, Open Source Robotics Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "class_loader/class_loader.hpp"
+#include "class_loader/multi_library_class_loader.hpp"
+
+#include "./base.hpp"
+
+#ifndef BENCHMARK_PLUGIN_LIBRARY_COUNT
+#error "BENCHMARK_PLUGIN_LIBRARY_COUNT must be defined"
+#endif
+
+#ifndef BENCHMARK_PLUGIN_CLASS_COUNT
+#error "BENCHMARK_PLUGIN_CLASS_COUNT must be defined"
+#endif
+
+const std::string LIBRARY_1 = class_loader::systemLibraryFormat("class_loader_TestPlugins1");  // NOLINT
+
+const int MAX_THREADS = 8;
+
+// The synthetic plugin libraries, @see benchmark_plugins.cpp
+std::string benchmarkPluginLibrary(int library_index)
+{
+  return class_loader::systemLibraryFormat(
+    "class_loader_BenchmarkPlugins" + std::to_string(library_index));
+}
+
+std::string benchmarkPluginClass(int library_index, int class_index)
+{
+  return "BenchmarkPlugin" + std::to_string(library_index) + "_" + std::to_string(class_index);
+}
+
+// A loader shared by the threads of the creation benchmarks, which stays loaded until exit
+class_loader::ClassLoader & sharedLoader()
+{
+  static class_loader::ClassLoader loader(LIBRARY_1, false);
+  return loader;
+}
+
+// Construction
+
+static void BM_ConstructLazyClassLoader(benchmark::State & state)
+{
+  for (auto _ : state) {
+    class_loader::ClassLoader loader(LIBRARY_1, true);
+    benchmark::DoNotOptimize(&loader);
+  }
+}
+BENCHMARK(BM_ConstructLazyClassLoader);
+
+static void BM_ConstructEagerClassLoader(benchmark::State & state)
+{
+  for (auto _ : state) {
+    class_loader::ClassLoader loader(LIBRARY_1, false);
+    benchmark::DoNotOptimize(&loader);
+  }
+}
+BENCHMARK(BM_ConstructEagerClassLoader);
+
+// Construction while another ClassLoader keeps the library open, so that only the metaobjects
+// are bound to the new one
+static void BM_ConstructEagerClassLoaderLibraryOpen(benchmark::State & state)
+{
+  class_loader::ClassLoader keep_open(LIBRARY_1, false);
+  for (auto _ : state) {
+    class_loader::ClassLoader loader(LIBRARY_1, false);
+    benchmark::DoNotOptimize(&loader);
+  }
+}
+BENCHMARK(BM_ConstructEagerClassLoaderLibraryOpen);
+
+// Creation
+
+static void BM_CreateSharedInstance(benchmark::State & state)
+{
+  class_loader::ClassLoader & loader = sharedLoader();
+  for (auto _ : state) {
+    std::shared_ptr<Base> obj = loader.createSharedInstance<Base>("Cat");
+    benchmark::DoNotOptimize(obj.get());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreateSharedInstance)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+static void BM_CreateUniqueInstance(benchmark::State & state)
+{
+  class_loader::ClassLoader & loader = sharedLoader();
+  for (auto _ : state) {
+    class_loader::ClassLoader::UniquePtr<Base> obj = loader.createUniqueInstance<Base>("Cat");
+    benchmark::DoNotOptimize(obj.get());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreateUniqueInstance)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+static void BM_CreateUniqueInstanceByClassId(benchmark::State & state)
+{
+  class_loader::ClassLoader & loader = sharedLoader();
+  class_loader::ClassId class_id = class_loader::ClassLoader::getClassId("Cat");
+  for (auto _ : state) {
+    class_loader::ClassLoader::UniquePtr<Base> obj = loader.createUniqueInstance<Base>(class_id);
+    benchmark::DoNotOptimize(obj.get());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreateUniqueInstanceByClassId)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+// Bulk creation, the argument is the number of instances per batch
+
+static void BM_CreateSharedInstances(benchmark::State & state)
+{
+  class_loader::ClassLoader & loader = sharedLoader();
+  std::vector<std::string> class_names(static_cast<size_t>(state.range(0)), "Cat");
+  for (auto _ : state) {
+    std::vector<std::shared_ptr<Base>> objs = loader.createSharedInstances<Base>(class_names);
+    benchmark::DoNotOptimize(objs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateSharedInstances)->RangeMultiplier(8)->Range(8, 512);
+
+// Lookup across libraries, the argument is the number of synthetic libraries loaded
+
+static void BM_MultiLibraryCreateUniqueInstance(benchmark::State & state)
+{
+  const int num_libraries = static_cast<int>(state.range(0));
+  class_loader::MultiLibraryClassLoader loader(false);
+  std::vector<std::string> class_names;
+  for (int l = 0; l < num_libraries; ++l) {
+    loader.loadLibrary(benchmarkPluginLibrary(l));
+    for (int c = 0; c < BENCHMARK_PLUGIN_CLASS_COUNT; ++c) {
+      class_names.push_back(benchmarkPluginClass(l, c));
+    }
+  }
+
+  size_t next = 0;
+  for (auto _ : state) {
+    class_loader::ClassLoader::UniquePtr<Base> obj =
+      loader.createUniqueInstance<Base>(class_names[next]);
+    benchmark::DoNotOptimize(obj.get());
+    next = (next + 1) % class_names.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MultiLibraryCreateUniqueInstance)
+->RangeMultiplier(2)->Range(1, BENCHMARK_PLUGIN_LIBRARY_COUNT);
+
+static void BM_MultiLibraryIsClassAvailable(benchmark::State & state)
+{
+  const int num_libraries = static_cast<int>(state.range(0));
+  class_loader::MultiLibraryClassLoader loader(false);
+  for (int l = 0; l < num_libraries; ++l) {
+    loader.loadLibrary(benchmarkPluginLibrary(l));
+  }
+  // The class of the last library loaded
+  const std::string class_name = benchmarkPluginClass(num_libraries - 1, 0);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(loader.isClassAvailable<Base>(class_name));
+  }
+}
+BENCHMARK(BM_MultiLibraryIsClassAvailable)
+->RangeMultiplier(2)->Range(1, BENCHMARK_PLUGIN_LIBRARY_COUNT);
+
+// Enumeration, the argument is the number of synthetic libraries loaded
+
+static void BM_GetAvailableClasses(benchmark::State & state)
+{
+  const int num_libraries = static_cast<int>(state.range(0));
+  std::vector<std::unique_ptr<class_loader::ClassLoader>> loaders;
+  for (int l = 0; l < num_libraries; ++l) {
+    loaders.emplace_back(new class_loader::ClassLoader(benchmarkPluginLibrary(l), false));
+  }
+
+  for (auto _ : state) {
+    std::vector<std::string> classes = loaders.back()->getAvailableClasses<Base>();
+    benchmark::DoNotOptimize(classes.data());
+  }
+}
+BENCHMARK(BM_GetAvailableClasses)->RangeMultiplier(2)->Range(1, BENCHMARK_PLUGIN_LIBRARY_COUNT);
+
+static void BM_MultiLibraryGetAvailableClasses(benchmark::State & state)
+{
+  const int num_libraries = static_cast<int>(state.range(0));
+  class_loader::MultiLibraryClassLoader loader(false);
+  for (int l = 0; l < num_libraries; ++l) {
+    loader.loadLibrary(benchmarkPluginLibrary(l));
+  }
+
+  for (auto _ : state) {
+    std::vector<std::string> classes = loader.getAvailableClasses<Base>();
+    benchmark::DoNotOptimize(classes.data());
+  }
+  state.SetItemsProcessed(state.iterations() * num_libraries * BENCHMARK_PLUGIN_CLASS_COUNT);
+}
+BENCHMARK(BM_MultiLibraryGetAvailableClasses)
+->RangeMultiplier(2)->Range(1, BENCHMARK_PLUGIN_LIBRARY_COUNT);
+
+static void BM_MultiLibraryForEachAvailableClass(benchmark::State & state)
+{
+  const int num_libraries = static_cast<int>(state.range(0));
+  class_loader::MultiLibraryClassLoader loader(false);
+  for (int l = 0; l < num_libraries; ++l) {
+    loader.loadLibrary(benchmarkPluginLibrary(l));
+  }
+
+  for (auto _ : state) {
+    size_t length = 0;
+    loader.forEachAvailableClass<Base>(
+      [&length](const std::string & class_name) {length += class_name.size();});
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetItemsProcessed(state.iterations() * num_libraries * BENCHMARK_PLUGIN_CLASS_COUNT);
+}
+BENCHMARK(BM_MultiLibraryForEachAvailableClass)
+->RangeMultiplier(2)->Range(1, BENCHMARK_PLUGIN_LIBRARY_COUNT);
+
+// Load/unload cycles. Whether the reloads revive factories from the graveyard depends on the
+// runtime loader actually closing the library, which is reported through the statistics.
+
+static void BM_LoadUnloadCycle(benchmark::State & state)
+{
+  class_loader::ClassLoader loader(benchmarkPluginLibrary(0), true);
+  class_loader::impl::resetStatistics();
+  for (auto _ : state) {
+    loader.loadLibrary();
+    loader.unloadLibrary();
+  }
+
+  for (const auto & library : class_loader::impl::getStatistics().libraries) {
+    if (library.library_path == benchmarkPluginLibrary(0)) {
+      state.counters["loads"] = static_cast<double>(library.load_count);
+      state.counters["revivals"] = static_cast<double>(library.graveyard_revival_count);
+    }
+  }
+}
+BENCHMARK(BM_LoadUnloadCycle);
+
+static void BM_OnDemandCreateCycle(benchmark::State & state)
+{
+  class_loader::ClassLoader loader(LIBRARY_1, true);
+  for (auto _ : state) {
+    // Loads the library and unloads it again as the only object is destroyed
+    std::shared_ptr<Base> obj = loader.createSharedInstance<Base>("Cat");
+    benchmark::DoNotOptimize(obj.get());
+  }
+}
+BENCHMARK(BM_OnDemandCreateCycle);
+
+BENCHMARK_MAIN();
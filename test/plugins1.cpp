@@ -27,7 +27,11 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "class_loader/class_loader.hpp"
 
@@ -63,8 +67,45 @@ public:
   virtual void saySomething() {std::cout << "Baaah" << std::endl;}
 };
 
+class Parrot : public Base
+{
+public:
+  Parrot(std::string phrase, std::shared_ptr<std::vector<std::string>> transcript)
+  : phrase_(std::move(phrase)), transcript_(std::move(transcript)) {}
+  virtual void saySomething()
+  {
+    std::cout << phrase_ << std::endl;
+    transcript_->push_back(phrase_);
+  }
+
+private:
+  std::string phrase_;
+  std::shared_ptr<std::vector<std::string>> transcript_;
+};
+
+// Creates its members through the class loader it was created with
+class Pack : public Base
+{
+public:
+  explicit Pack(std::function<std::shared_ptr<Base>(std::string)> create)
+  : leader_(create("Dog")), follower_(create("Dog")) {}
+  virtual void saySomething()
+  {
+    leader_->saySomething();
+    follower_->saySomething();
+  }
+
+private:
+  std::shared_ptr<Base> leader_;
+  std::shared_ptr<Base> follower_;
+};
+
 CLASS_LOADER_REGISTER_CLASS(Dog, Base)
 CLASS_LOADER_REGISTER_CLASS(Cat, Base)
 CLASS_LOADER_REGISTER_CLASS(Duck, Base)
 CLASS_LOADER_REGISTER_CLASS(Cow, Base)
 CLASS_LOADER_REGISTER_CLASS(Sheep, Base)
+CLASS_LOADER_REGISTER_CLASS_WITH_ARGS(
+  Parrot, Base, std::string, std::shared_ptr<std::vector<std::string>>)
+CLASS_LOADER_REGISTER_CLASS_WITH_ARGS(
+  Pack, Base, std::function<std::shared_ptr<Base>(std::string)>)
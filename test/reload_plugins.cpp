@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2012, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Plugin library standing in for successive builds of a library that is reloaded. The build
+// compiles this file into several libraries, each with its own RELOAD_PLUGINS_REVISION.
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "class_loader/class_loader.hpp"
+
+#include "./base.hpp"
+
+#ifndef RELOAD_PLUGINS_REVISION
+#define RELOAD_PLUGINS_REVISION 1
+#endif
+
+// Note: Not inline, so that a build exporting its symbols exports this function as well
+int getRevision()
+{
+  return RELOAD_PLUGINS_REVISION;
+}
+
+class Revision : public Base
+{
+public:
+  explicit Revision(std::shared_ptr<std::vector<int>> transcript)
+  : transcript_(std::move(transcript)) {}
+  virtual void saySomething() {transcript_->push_back(getRevision());}
+
+private:
+  std::shared_ptr<std::vector<int>> transcript_;
+};
+
+CLASS_LOADER_REGISTER_CLASS_WITH_ARGS(Revision, Base, std::shared_ptr<std::vector<int>>)
@@ -195,6 +195,143 @@ TEST(ClassLoaderSharedPtrTest, threadSafety) {
   }
 }
 
+void createAndDestroy(class_loader::ClassLoader * loader, size_t iterations)
+{
+  for (size_t c = 0; c < iterations; c++) {
+    std::shared_ptr<Base> obj = loader->createSharedInstance<Base>("Dog");
+    std::shared_ptr<Base> other = loader->createSharedInstance<Base>("Cat");
+  }
+}
+
+TEST(ClassLoaderSharedPtrTest, threadSafetyOnDemand) {
+  class_loader::ClassLoader loader1(LIBRARY_1, true);
+
+  // Note: Threads keep racing the last instance going away, which unloads the library, against
+  // new instances being created, which must find it loaded.
+  try {
+    std::vector<std::thread> client_threads;
+    for (size_t c = 0; c < 16; c++) {
+      client_threads.emplace_back(&createAndDestroy, &loader1, 200);
+    }
+    for (auto & client_thread : client_threads) {
+      client_thread.join();
+    }
+    ASSERT_FALSE(loader1.isLibraryLoaded());
+    ASSERT_FALSE(loader1.isLibraryLoadedByAnyClassloader());
+  } catch (const class_loader::ClassLoaderException & e) {
+    FAIL() << "Unexpected ClassLoaderException: " << e.what();
+  }
+}
+
+TEST(ClassLoaderSharedPtrTest, factoryHandle) {
+  try {
+    class_loader::ClassLoader loader1(LIBRARY_1, false);
+    class_loader::FactoryHandle<Base> cat = loader1.getFactory<Base>("Cat");
+    ASSERT_TRUE(cat.isValid());
+    ASSERT_EQ("Cat", cat.getClassName());
+    for (size_t c = 0; c < 10; c++) {
+      cat.createShared()->saySomething();
+    }
+    cat.createUnique()->saySomething();
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+
+  class_loader::FactoryHandle<Base> unbound;
+  ASSERT_FALSE(unbound.isValid());
+  EXPECT_THROW(unbound.createShared(), class_loader::CreateClassException);
+
+  class_loader::ClassLoader loader1(LIBRARY_1, false);
+  EXPECT_THROW(loader1.getFactory<Base>("Bear"), class_loader::CreateClassException);
+}
+
+TEST(ClassLoaderSharedPtrTest, factoryHandleSurvivesUnload) {
+  try {
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    class_loader::FactoryHandle<Base> dog = loader1.getFactory<Base>("Dog");
+    loader1.unloadLibrary();
+    ASSERT_FALSE(loader1.isLibraryLoaded());
+    ASSERT_FALSE(dog.isValid());
+
+    for (size_t c = 0; c < 3; c++) {
+      {
+        std::shared_ptr<Base> obj = dog.createShared();
+        ASSERT_TRUE(loader1.isLibraryLoaded());
+        obj->saySomething();
+      }
+      // The library unloads with the last plugin object, the handle has to notice
+      ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+      ASSERT_FALSE(dog.isValid());
+    }
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+}
+
+TEST(ClassLoaderSharedPtrTest, pooledInstancesReuseStorage) {
+  try {
+    class_loader::ClassLoader loader1(LIBRARY_1, false);
+    void * storage = nullptr;
+    {
+      std::shared_ptr<Base> obj = loader1.createPooledSharedInstance<Base>("Dog");
+      obj->saySomething();
+      storage = dynamic_cast<void *>(obj.get());
+    }
+    {
+      std::shared_ptr<Base> obj = loader1.createPooledSharedInstance<Base>("Dog");
+      ASSERT_EQ(storage, dynamic_cast<void *>(obj.get()));
+      std::shared_ptr<Base> other = loader1.createPooledSharedInstance<Base>("Dog");
+      ASSERT_NE(storage, dynamic_cast<void *>(other.get()));
+    }
+    class_loader::ClassLoader::UniquePtr<Base> obj =
+      loader1.createPooledUniqueInstance<Base>("Cat");
+    obj->saySomething();
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+}
+
+TEST(ClassLoaderSharedPtrTest, pooledInstancesLazyLoadUnload) {
+  try {
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    ASSERT_FALSE(loader1.isLibraryLoaded());
+    for (size_t c = 0; c < 3; c++) {
+      {
+        std::shared_ptr<Base> obj = loader1.createPooledSharedInstance<Base>("Sheep");
+        ASSERT_TRUE(loader1.isLibraryLoaded());
+        obj->saySomething();
+      }
+      // The pool is released with the library once the last plugin object goes away
+      ASSERT_FALSE(loader1.isLibraryLoaded());
+    }
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+}
+
+TEST(ClassLoaderSharedPtrTest, allocatedInstancesLazyLoadUnload) {
+  try {
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    std::weak_ptr<Base> weak;
+    {
+      std::shared_ptr<Base> obj = loader1.allocateSharedInstance<Base>("Cow");
+      ASSERT_TRUE(loader1.isLibraryLoaded());
+      obj->saySomething();
+      std::shared_ptr<Base> copy = obj;
+      weak = copy;
+    }
+    // The control block may outlive both the plugin object and its library
+    ASSERT_TRUE(weak.expired());
+    ASSERT_FALSE(loader1.isLibraryLoaded());
+    weak.reset();
+
+    std::shared_ptr<Base> obj = loader1.allocateSharedInstance<Base>("Duck");
+    obj->saySomething();
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+}
+
 TEST(ClassLoaderSharedPtrTest, loadRefCountingNonLazy) {
   try {
     class_loader::ClassLoader loader1(LIBRARY_1, false);
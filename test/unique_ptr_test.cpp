@@ -39,6 +39,7 @@
 #include <iostream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "./base.hpp"
@@ -81,6 +82,20 @@ TEST(ClassLoaderUniquePtrTest, correctLazyLoadUnload) {
   }
 }
 
+TEST(ClassLoaderUniquePtrTest, deleterIsNotTypeErased) {
+  // The deleter only references the ClassLoader (and factory of pooled instances)
+  static_assert(
+    sizeof(class_loader::ClassLoader::UniquePtr<Base>) <= 3 * sizeof(void *),
+    "ClassLoader::UniquePtr should not carry a type-erased deleter");
+  class_loader::ClassLoader loader1(LIBRARY_1, true);
+  class_loader::ClassLoader::UniquePtr<Base> obj = loader1.createUniqueInstance<Base>("Cat");
+  ASSERT_TRUE(loader1.isLibraryLoaded());
+  class_loader::ClassLoader::UniquePtr<Base> moved = std::move(obj);
+  moved->saySomething();
+  moved.reset();
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+}
+
 TEST(ClassLoaderUniquePtrTest, nonExistentPlugin) {
   ClassLoader loader1(LIBRARY_1, false);
 
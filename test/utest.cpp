@@ -27,16 +27,37 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#ifdef __linux__
+#include <dirent.h>
+#include <link.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "class_loader/class_loader.hpp"
 #include "class_loader/multi_library_class_loader.hpp"
+#ifdef __ELF__
+#include "class_loader/static_registry.hpp"
+#endif
+#include "class_loader/tracer.hpp"
 
 #include "gtest/gtest.h"
 
@@ -44,6 +65,12 @@
 
 const std::string LIBRARY_1 = class_loader::systemLibraryFormat("class_loader_TestPlugins1");  // NOLINT
 const std::string LIBRARY_2 = class_loader::systemLibraryFormat("class_loader_TestPlugins2");  // NOLINT
+const std::string RELOAD_LIBRARY_1 =  // NOLINT
+  class_loader::systemLibraryFormat("class_loader_TestReloadPlugins1");
+const std::string RELOAD_LIBRARY_2 =  // NOLINT
+  class_loader::systemLibraryFormat("class_loader_TestReloadPlugins2");
+const std::string RELOAD_LIBRARY_EXPORTED =  // NOLINT
+  class_loader::systemLibraryFormat("class_loader_TestReloadPluginsExported");
 
 TEST(ClassLoaderTest, basicLoad) {
   try {
@@ -116,6 +143,27 @@ TEST(ClassLoaderTest, nonExistentPlugin) {
   FAIL() << "Did not throw exception as expected.\n";
 }
 
+TEST(ClassLoaderTest, createByClassId) {
+  class_loader::ClassId cat = class_loader::ClassLoader::getClassId("Cat");
+  class_loader::ClassId bear = class_loader::ClassLoader::getClassId("Bear");
+  ASSERT_EQ(cat, class_loader::ClassLoader::getClassId("Cat"));
+  ASSERT_NE(cat, bear);
+
+  class_loader::ClassLoader loader1(LIBRARY_1, true);
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+  {
+    boost::shared_ptr<Base> obj = loader1.createInstance<Base>(cat);
+    ASSERT_TRUE(obj != nullptr);
+    ASSERT_TRUE(loader1.isLibraryLoaded());
+    obj->saySomething();
+    std::shared_ptr<Base> shared_obj = loader1.createSharedInstance<Base>(cat);
+    ASSERT_TRUE(shared_obj != nullptr);
+  }
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+
+  EXPECT_THROW(loader1.createInstance<Base>(bear), class_loader::CreateClassException);
+}
+
 TEST(ClassLoaderTest, nonExistentLibrary) {
   try {
     class_loader::ClassLoader loader1("libDoesNotExist.so", false);
@@ -195,6 +243,627 @@ TEST(ClassLoaderTest, threadSafety) {
   }
 }
 
+void createThroughMultiLibraryClassLoader(
+  class_loader::MultiLibraryClassLoader * loader, size_t iterations)
+{
+  for (size_t c = 0; c < iterations; c++) {
+    loader->createSharedInstance<Base>("Dog");
+    loader->createUniqueInstance<Base>("Cat", LIBRARY_1);
+    loader->getAvailableClasses<Base>();
+    loader->isLibraryAvailable(LIBRARY_2);
+  }
+}
+
+TEST(MultiClassLoaderTest, threadSafety) {
+  class_loader::MultiLibraryClassLoader loader(false);
+  loader.loadLibrary(LIBRARY_1);
+
+  // Note: Instances are created from one library while the other one keeps being loaded and
+  // unloaded, which modifies the class loaders and index the creators look through.
+  try {
+    std::atomic<bool> done(false);
+    std::thread churn_thread([&loader, &done]() {
+        while (!done) {
+          loader.loadLibrary(LIBRARY_2);
+          loader.unloadLibrary(LIBRARY_2);
+        }
+      });
+
+    std::vector<std::thread> client_threads;
+    for (size_t c = 0; c < 16; c++) {
+      client_threads.emplace_back(&createThroughMultiLibraryClassLoader, &loader, 100);
+    }
+    for (auto & client_thread : client_threads) {
+      client_thread.join();
+    }
+    done = true;
+    churn_thread.join();
+
+    ASSERT_FALSE(loader.isLibraryAvailable(LIBRARY_2));
+    std::vector<std::string> libraries = loader.getRegisteredLibraries();
+    ASSERT_EQ(1u, libraries.size());
+  } catch (const class_loader::ClassLoaderException & e) {
+    FAIL() << "Unexpected ClassLoaderException: " << e.what();
+  }
+}
+
+TEST(ClassLoaderTest, unloadDoesNotDisturbOtherLibraries) {
+  class_loader::ClassLoader loader1(LIBRARY_1, false);
+  class_loader::ClassLoader loader2(LIBRARY_2, true);
+  std::atomic<bool> done(false);
+  std::thread unloader([&loader2, &done]() {
+      for (size_t c = 0; c < 100; c++) {
+        // Note: The library is unloaded as the instance is destroyed
+        loader2.createSharedInstance<Base>("Robot")->saySomething();
+      }
+      done = true;
+    });
+  do {
+    loader1.createSharedInstance<Base>("Dog");
+    ASSERT_TRUE(loader1.isClassAvailable<Base>("Cat"));
+  } while (!done);
+  unloader.join();
+  ASSERT_FALSE(loader2.isLibraryLoaded());
+  ASSERT_TRUE(loader1.isLibraryLoaded());
+}
+
+TEST(ClassLoaderTest, libraryLoadedPerClassLoaderScope) {
+  try {
+    class_loader::ClassLoader loader1(LIBRARY_1, false);
+    class_loader::ClassLoader loader2(LIBRARY_1, true);
+    ASSERT_TRUE(loader1.isLibraryLoaded());
+    ASSERT_TRUE(loader2.isLibraryLoadedByAnyClassloader());
+    // The library is in memory, but loader2 has not bound its metaobjects yet
+    ASSERT_FALSE(loader2.isLibraryLoaded());
+    ASSERT_TRUE(class_loader::impl::getAllLibrariesUsedByClassLoader(&loader2).empty());
+
+    loader2.createInstance<Base>("Cat")->saySomething();
+    ASSERT_TRUE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+
+    std::vector<std::string> libraries =
+      class_loader::impl::getAllLibrariesUsedByClassLoader(&loader1);
+    ASSERT_EQ(1u, libraries.size());
+    ASSERT_EQ(LIBRARY_1, libraries[0]);
+
+    loader1.unloadLibrary();
+    ASSERT_FALSE(loader1.isLibraryLoaded());
+    ASSERT_TRUE(class_loader::impl::getAllLibrariesUsedByClassLoader(&loader1).empty());
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+}
+
+TEST(ClassLoaderTest, manyClassLoadersOwnSameLibrary) {
+  // More class loaders than owner bits are stored inline
+  std::vector<std::unique_ptr<class_loader::ClassLoader>> loaders;
+  for (size_t i = 0; i < 100; ++i) {
+    loaders.emplace_back(new class_loader::ClassLoader(LIBRARY_1, false));
+  }
+  for (auto & loader : loaders) {
+    ASSERT_TRUE(loader->isLibraryLoaded());
+    ASSERT_TRUE(loader->isClassAvailable<Base>("Cat"));
+    loader->createUniqueInstance<Base>("Cat")->saySomething();
+  }
+
+  // Unloading through some of them leaves the others unaffected
+  for (size_t i = 0; i < loaders.size(); i += 2) {
+    loaders[i]->unloadLibrary();
+  }
+  for (size_t i = 0; i < loaders.size(); ++i) {
+    ASSERT_EQ(i % 2 != 0, loaders[i]->isLibraryLoaded());
+  }
+
+  // IDs freed by destroyed class loaders are reused without inheriting ownership
+  loaders.resize(50);
+  class_loader::ClassLoader loader(LIBRARY_1, true);
+  ASSERT_FALSE(loader.isLibraryLoaded());
+  loaders.clear();
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+}
+
+TEST(ClassLoaderTest, createSharedInstances) {
+  class_loader::ClassLoader loader1(LIBRARY_1, true);
+  {
+    std::vector<std::shared_ptr<Base>> objs =
+      loader1.createSharedInstances<Base>({"Cat", "Dog", "Cat"});
+    ASSERT_EQ(3u, objs.size());
+    for (auto & obj : objs) {
+      obj->saySomething();
+    }
+    ASSERT_TRUE(loader1.isLibraryLoaded());
+  }
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+
+  std::vector<std::shared_ptr<Base>> objs =
+    loader1.createSharedInstances<Base>({"Cow", "Duck"}, {3, 0}, 4);
+  ASSERT_EQ(3u, objs.size());
+  ASSERT_TRUE(objs[0] && objs[1] && objs[2]);
+  objs.clear();
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+
+  // Nothing is left behind if one of the classes is unknown
+  EXPECT_THROW(
+    loader1.createSharedInstances<Base>({"Cat", "Bear"}), class_loader::CreateClassException);
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+}
+
+TEST(ClassLoaderTest, createWithConstructorArguments) {
+  typedef std::shared_ptr<std::vector<std::string>> Transcript;
+  class_loader::ClassLoader loader1(LIBRARY_1, false);
+  ASSERT_TRUE((loader1.isClassAvailable<Base(std::string, Transcript)>("Parrot")));
+  ASSERT_FALSE(loader1.isClassAvailable<Base>("Parrot"));
+
+  // Lvalues are copied, rvalues are moved into the constructor
+  std::string phrase = "Polly";
+  Transcript transcript = std::make_shared<std::vector<std::string>>();
+  Transcript moved_transcript = transcript;
+  std::shared_ptr<Base> parrot =
+    loader1.createSharedInstance<Base>("Parrot", phrase, std::move(moved_transcript));
+  ASSERT_EQ("Polly", phrase);
+  ASSERT_EQ(nullptr, moved_transcript);
+  parrot->saySomething();
+  ASSERT_EQ(std::vector<std::string>({"Polly"}), *transcript);
+
+  class_loader::ClassLoader::UniquePtr<Base> unique_parrot =
+    loader1.createUniqueInstance<Base>("Parrot", std::string("Cracker"), transcript);
+  unique_parrot->saySomething();
+  ASSERT_EQ(std::vector<std::string>({"Polly", "Cracker"}), *transcript);
+
+  // The arguments must match the registered signature
+  EXPECT_THROW(
+    loader1.createSharedInstance<Base>("Parrot", 42), class_loader::CreateClassException);
+  EXPECT_THROW(
+    loader1.createSharedInstance<Base>("Dog", std::string("x")),
+    class_loader::CreateClassException);
+
+  class_loader::MultiLibraryClassLoader loader2(false);
+  loader2.loadLibrary(LIBRARY_1);
+  loader2.createSharedInstanceWithArgs<Base>("Parrot", phrase, transcript)->saySomething();
+  ASSERT_EQ(3u, transcript->size());
+}
+
+TEST(ClassLoaderTest, loadFlags) {
+  class_loader::ClassLoader loader1(
+    LIBRARY_1, false, class_loader::LIBRARY_LOAD_NOW | class_loader::LIBRARY_LOAD_LOCAL);
+  ASSERT_EQ(
+    class_loader::LIBRARY_LOAD_NOW | class_loader::LIBRARY_LOAD_LOCAL,
+    loader1.getLibraryLoadFlags());
+  loader1.createInstance<Base>("Cat")->saySomething();
+}
+
+class CountingLibraryBackend : public class_loader::impl::LibraryBackend
+{
+public:
+  class_loader::impl::LibraryHandle open(const std::string & library_path, int flags)
+  {
+    ++num_opens;
+    last_flags = flags;
+    return class_loader::impl::getNativeLibraryBackend().open(library_path, flags);
+  }
+
+  void close(class_loader::impl::LibraryHandle handle)
+  {
+    ++num_closes;
+    class_loader::impl::getNativeLibraryBackend().close(handle);
+  }
+
+  size_t num_opens = 0;
+  size_t num_closes = 0;
+  int last_flags = -1;
+};
+
+TEST(ClassLoaderTest, customLibraryBackend) {
+  CountingLibraryBackend backend;
+  class_loader::impl::setLibraryBackend(backend);
+  {
+    class_loader::ClassLoader loader1(LIBRARY_1, true, class_loader::LIBRARY_LOAD_NOW);
+    loader1.createInstance<Base>("Cat")->saySomething();
+    loader1.createInstance<Base>("Dog")->saySomething();
+  }
+  class_loader::impl::setLibraryBackend(class_loader::impl::getNativeLibraryBackend());
+  ASSERT_EQ(2u, backend.num_opens);
+  ASSERT_EQ(2u, backend.num_closes);
+  ASSERT_EQ(class_loader::LIBRARY_LOAD_NOW, backend.last_flags);
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+}
+
+TEST(ClassLoaderTest, prefetchLoadsLazyLibrary) {
+  class_loader::ClassLoader loader1(LIBRARY_1, true);
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+  loader1.prefetch(true).get();
+  ASSERT_TRUE(loader1.isLibraryLoaded());
+#ifdef __linux__
+  ASSERT_GT(class_loader::impl::prefaultLibrary(LIBRARY_1), 0u);
+#endif
+
+  // The library was loaded for the first plugin, which unloads it again
+  loader1.createSharedInstance<Base>("Cat")->saySomething();
+  ASSERT_FALSE(loader1.isLibraryLoaded());
+  ASSERT_EQ(0u, class_loader::impl::prefaultLibrary(LIBRARY_1));
+
+  class_loader::ClassLoader loader2("libDoesNotExist.so", true);
+  EXPECT_THROW(loader2.prefetch().get(), class_loader::LibraryLoadException);
+}
+
+TEST(ClassLoaderTest, deferredUnloadAfterGracePeriod) {
+  {
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    loader1.setUnloadGracePeriod(std::chrono::milliseconds(500));
+    loader1.createSharedInstance<Base>("Cat")->saySomething();
+    ASSERT_TRUE(loader1.isLibraryLoaded());
+    // Creating a plugin within the grace period cancels the unload
+    loader1.createSharedInstance<Base>("Dog")->saySomething();
+    ASSERT_TRUE(loader1.isLibraryLoaded());
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (loader1.isLibraryLoaded() && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_FALSE(loader1.isLibraryLoaded());
+    ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+  }
+
+  {
+    // A pending unload does not keep the library loaded beyond its ClassLoader
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    loader1.setUnloadGracePeriod(std::chrono::hours(1));
+    loader1.createSharedInstance<Base>("Cat")->saySomething();
+    ASSERT_TRUE(loader1.isLibraryLoaded());
+  }
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+}
+
+#ifndef CLASS_LOADER_DISABLE_STATISTICS
+TEST(ClassLoaderTest, statisticsCountLoadsAndCreations) {
+  class_loader::impl::resetStatistics();
+  {
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    loader1.createUniqueInstance<Base>("Cat")->saySomething();
+    loader1.createSharedInstance<Base>("Cat")->saySomething();
+    loader1.createPooledSharedInstance<Base>("Dog")->saySomething();
+  }
+
+  class_loader::impl::Statistics statistics = class_loader::impl::getStatistics();
+  const class_loader::impl::LibraryStatistics * library = nullptr;
+  for (auto & it : statistics.libraries) {
+    if (it.library_path == LIBRARY_1) {
+      library = &it;
+    }
+  }
+  ASSERT_TRUE(library != nullptr);
+  // Each instance loaded and unloaded the library on demand
+  EXPECT_EQ(3u, library->load_count);
+  EXPECT_EQ(3u, library->unload_count);
+  EXPECT_GT(library->dlopen_time_ns, 0u);
+  EXPECT_LE(library->registration_time_ns, library->dlopen_time_ns);
+
+  size_t cat_creations = 0, cat_destructions = 0, dog_creations = 0, dog_destructions = 0;
+  for (auto & it : statistics.classes) {
+    if (it.library_path == LIBRARY_1 && it.class_name == "Cat") {
+      cat_creations += it.creation_count;
+      cat_destructions += it.destruction_count;
+    } else if (it.library_path == LIBRARY_1 && it.class_name == "Dog") {
+      dog_creations += it.creation_count;
+      dog_destructions += it.destruction_count;
+    }
+  }
+  EXPECT_EQ(2u, cat_creations);
+  EXPECT_EQ(2u, cat_destructions);
+  EXPECT_EQ(1u, dog_creations);
+  EXPECT_EQ(1u, dog_destructions);
+}
+#endif
+
+#ifndef CLASS_LOADER_DISABLE_TRACING
+class RecordingTracer : public class_loader::impl::Tracer
+{
+public:
+  void begin(class_loader::impl::TraceEvent event, const char * name)
+  {
+    events_.push_back(
+      std::string("B ") + class_loader::impl::getTraceEventName(event) + " " + name);
+  }
+
+  void end(class_loader::impl::TraceEvent event, const char * name)
+  {
+    events_.push_back(
+      std::string("E ") + class_loader::impl::getTraceEventName(event) + " " + name);
+  }
+
+  std::vector<std::string> events_;
+};
+
+TEST(ClassLoaderTest, tracerReceivesNestedSpans) {
+  RecordingTracer tracer;
+  class_loader::impl::setTracer(&tracer);
+  {
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    loader1.createSharedInstance<Base>("Cat")->saySomething();
+  }
+  class_loader::impl::setTracer(nullptr);
+  size_t num_events = tracer.events_.size();
+  {
+    class_loader::ClassLoader loader1(LIBRARY_1, true);
+    loader1.createSharedInstance<Base>("Cat")->saySomething();
+  }
+  ASSERT_EQ(num_events, tracer.events_.size());
+
+  // The factories are registered (or revived) while the library is opened, and the library is
+  // closed as the last instance is destroyed
+  const std::vector<std::string> & events = tracer.events_;
+  ASSERT_LE(8u, events.size());
+  EXPECT_EQ("B library_open " + LIBRARY_1, events.front());
+  EXPECT_TRUE(
+    std::find(events.begin(), events.end(), "E registration Cat") != events.end() ||
+    std::find(events.begin(), events.end(), "E graveyard_revive " + LIBRARY_1) != events.end());
+  std::vector<std::string> last_events(events.end() - 6, events.end());
+  EXPECT_EQ(
+    std::vector<std::string>({
+      "B instance_create Cat", "E instance_create Cat", "B instance_destroy Cat",
+      "B library_close " + LIBRARY_1, "E library_close " + LIBRARY_1, "E instance_destroy Cat"}),
+    last_events);
+
+  std::vector<std::string> open_spans;
+  for (auto & event : events) {
+    if ('B' == event[0]) {
+      open_spans.push_back(event.substr(2));
+    } else {
+      ASSERT_FALSE(open_spans.empty());
+      ASSERT_EQ(open_spans.back(), event.substr(2));
+      open_spans.pop_back();
+    }
+  }
+  EXPECT_TRUE(open_spans.empty());
+}
+
+TEST(ClassLoaderTest, traceEventFileTracerWritesJson) {
+  const std::string path = testing::TempDir() + "class_loader_trace_test.json";
+  {
+    class_loader::impl::TraceEventFileTracer tracer(path);
+    class_loader::impl::setTracer(&tracer);
+    class_loader::ClassLoader loader1(LIBRARY_1, false);
+    loader1.createInstance<Base>("Dog")->saySomething();
+    class_loader::impl::setTracer(nullptr);
+  }
+
+  std::ifstream file(path.c_str());
+  std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::remove(path.c_str());
+  EXPECT_EQ('[', trace.front());
+  EXPECT_EQ("]\n", trace.substr(trace.size() - 2));
+  EXPECT_NE(std::string::npos, trace.find(
+      "{\"name\":\"instance_create\",\"cat\":\"class_loader\",\"ph\":\"B\""));
+  EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"Dog\"}}"));
+}
+#endif
+
+TEST(ClassLoaderTest, memoryUsageOfRegistry) {
+  class_loader::impl::MemoryUsage before = class_loader::impl::getMemoryUsage();
+  class_loader::impl::MemoryUsage loaded;
+  {
+    class_loader::ClassLoader loader1(LIBRARY_1, false);
+    loaded = class_loader::impl::getMemoryUsage();
+    EXPECT_EQ(before.loaded_library_count + 1, loaded.loaded_library_count);
+#ifdef __linux__
+    EXPECT_GT(loaded.mapped_library_bytes, before.mapped_library_bytes);
+#endif
+    EXPECT_LT(before.meta_object_count, loaded.meta_object_count);
+    EXPECT_LT(0u, loaded.registry_bytes);
+    EXPECT_LE(
+      loaded.meta_object_count * sizeof(class_loader::impl::AbstractMetaObjectBase),
+      loaded.meta_object_bytes);
+    EXPECT_LE(
+      loaded.meta_object_count * sizeof(class_loader::impl::AbstractMetaObjectBase),
+      loaded.arena_bytes);
+
+    // The factories share a single copy of the names of their base class and library
+    class_loader::impl::AbstractMetaObjectBase * cat =
+      class_loader::impl::findFactory(typeid(Base).name(), "Cat");
+    class_loader::impl::AbstractMetaObjectBase * dog =
+      class_loader::impl::findFactory(typeid(Base).name(), "Dog");
+    ASSERT_TRUE(cat != nullptr && dog != nullptr);
+    EXPECT_EQ(&cat->baseClassName(), &dog->baseClassName());
+    EXPECT_EQ(&cat->getAssociatedLibraryPath(), &dog->getAssociatedLibraryPath());
+  }
+
+  // The factories are kept in the graveyard once the library is unloaded
+  class_loader::impl::MemoryUsage unloaded = class_loader::impl::getMemoryUsage();
+  EXPECT_EQ(before.loaded_library_count, unloaded.loaded_library_count);
+  EXPECT_EQ(before.meta_object_count, unloaded.meta_object_count);
+  EXPECT_EQ(
+    loaded.meta_object_count + loaded.graveyard_meta_object_count,
+    unloaded.meta_object_count + unloaded.graveyard_meta_object_count);
+  EXPECT_GE(unloaded.arena_bytes, loaded.arena_bytes);
+}
+
+TEST(ClassLoaderTest, manifestListsClassesWithoutLoading) {
+  ASSERT_TRUE(class_loader::impl::hasLibraryManifest(LIBRARY_2));
+  ASSERT_FALSE(class_loader::impl::hasLibraryManifest(LIBRARY_1));
+
+  try {
+    class_loader::ClassLoader loader2(LIBRARY_2, true);
+    std::vector<std::string> classes = loader2.getAvailableClasses<Base>();
+    ASSERT_EQ(4u, classes.size());
+    ASSERT_TRUE(loader2.isClassAvailable<Base>("Robot"));
+    ASSERT_FALSE(loader2.isClassAvailable<InvalidBase>("Robot"));
+    ASSERT_FALSE(loader2.isLibraryLoadedByAnyClassloader());
+
+    loader2.createInstance<Base>("Robot")->saySomething();
+    ASSERT_FALSE(loader2.isLibraryLoadedByAnyClassloader());
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+}
+
+#ifndef _WIN32
+namespace unrelated
+{
+class Base
+{
+};
+}  // namespace unrelated
+
+TEST(ClassLoaderTest, manifestMissingClassesFallsBackToLibrary) {
+  // Note: A copy of LIBRARY_2 whose manifest misses classes, as it does for classes registered in
+  // ways its generator does not recognize
+  const std::string library_path = class_loader::impl::createLibrarySnapshot(LIBRARY_2);
+  {
+    std::ofstream manifest((library_path + ".classes").c_str());
+    manifest << "Robot Base\n";
+  }
+  {
+    class_loader::ClassLoader loader(library_path, true);
+    ASSERT_EQ(std::vector<std::string>({"Robot"}), loader.getAvailableClasses<Base>());
+    ASSERT_TRUE(loader.isClassAvailable<Base>("Robot"));
+    ASSERT_FALSE(loader.isLibraryLoadedByAnyClassloader());
+    ASSERT_TRUE(loader.isClassAvailable<Base>("Zombie"));
+    ASSERT_FALSE(loader.isClassAvailable<Base>("NotAClass"));
+    ASSERT_FALSE(loader.isLibraryLoadedByAnyClassloader());
+
+    // Base classes are matched by their full name
+    ASSERT_TRUE(loader.getAvailableClasses<unrelated::Base>().empty());
+  }
+  {
+    class_loader::MultiLibraryClassLoader loader(true);
+    loader.loadLibrary(LIBRARY_1);
+    loader.loadLibrary(library_path);
+    loader.createInstance<Base>("Zombie")->saySomething();
+    loader.createInstance<Base>("Cat")->saySomething();
+    ASSERT_FALSE(loader.isClassAvailable<Base>("NotAClass"));
+  }
+  std::remove((library_path + ".classes").c_str());
+  std::remove(library_path.c_str());
+}
+#endif
+
+TEST(ClassLoaderTest, forEachAvailableClass) {
+  class_loader::ClassLoader loader1(LIBRARY_1, false);
+  class_loader::ClassLoader loader2(LIBRARY_2, true);
+  for (class_loader::ClassLoader * loader : {&loader1, &loader2}) {
+    std::vector<std::string> classes;
+    loader->forEachAvailableClass<Base>(
+      [&classes](const std::string & class_name) {classes.push_back(class_name);});
+    std::sort(classes.begin(), classes.end());
+    std::vector<std::string> expected_classes = loader->getAvailableClasses<Base>();
+    std::sort(expected_classes.begin(), expected_classes.end());
+    ASSERT_EQ(expected_classes, classes);
+    for (auto & class_name : classes) {
+      ASSERT_TRUE(loader->isClassAvailable<Base>(class_name));
+      ASSERT_FALSE(loader->isClassAvailable<InvalidBase>(class_name));
+    }
+    ASSERT_FALSE(loader->isClassAvailable<Base>("NotAClass"));
+  }
+  // LIBRARY_2 was listed from its manifest
+  ASSERT_FALSE(loader2.isLibraryLoadedByAnyClassloader());
+}
+
+TEST(MultiClassLoaderTest, forEachAvailableClass) {
+  class_loader::MultiLibraryClassLoader loader(false);
+  loader.loadLibrary(LIBRARY_1);
+  loader.loadLibrary(LIBRARY_2);
+  size_t count = 0;
+  loader.forEachAvailableClass<Base>([&count](const std::string &) {++count;});
+  ASSERT_EQ(loader.getAvailableClasses<Base>().size(), count);
+  ASSERT_TRUE(loader.isClassAvailable<Base>("Cat"));
+  ASSERT_TRUE(loader.isClassAvailable<Base>("Robot"));
+  ASSERT_FALSE(loader.isClassAvailable<Base>("NotAClass"));
+  ASSERT_FALSE(loader.isClassAvailable<InvalidBase>("Cat"));
+}
+
+TEST(MultiClassLoaderTest, lazyLookupOnlyLoadsNeededLibrary) {
+  class_loader::MultiLibraryClassLoader loader(true);
+  loader.loadLibrary(LIBRARY_2);
+  loader.loadLibrary(LIBRARY_1);
+  loader.createInstance<Base>("Cat")->saySomething();
+  // LIBRARY_2 has a manifest which does not list Cat, so it did not need to be opened
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_2));
+  ASSERT_TRUE(loader.isClassAvailable<Base>("Zombie"));
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_2));
+}
+
+void createRepeatedly(class_loader::ClassLoader * loader, const std::string & class_name)
+{
+  for (size_t c = 0; c < 1000; c++) {
+    loader->createInstance<Base>(class_name);
+  }
+}
+
+TEST(ClassLoaderTest, createWhileOtherLibraryLoadsAndUnloads) {
+  class_loader::ClassLoader loader1(LIBRARY_1);
+  ASSERT_TRUE(loader1.isLibraryLoaded());
+
+  try {
+    std::vector<std::thread> client_threads;
+    for (size_t c = 0; c < 8; c++) {
+      client_threads.emplace_back(std::bind(&createRepeatedly, &loader1, "Cat"));
+    }
+
+    // Every load/unload of LIBRARY_2 invalidates the factory index the threads above read from
+    for (size_t c = 0; c < 20; c++) {
+      class_loader::ClassLoader loader2(LIBRARY_2);
+      loader2.createInstance<Base>("Robot")->saySomething();
+    }
+
+    for (auto & client_thread : client_threads) {
+      client_thread.join();
+    }
+  } catch (const class_loader::ClassLoaderException & e) {
+    FAIL() << "Unexpected ClassLoaderException: " << e.what();
+  }
+}
+
+void loadAndCheckClasses(const std::string & library_path, size_t num_classes)
+{
+  for (size_t c = 0; c < 20; c++) {
+    class_loader::ClassLoader loader(library_path);
+    ASSERT_EQ(num_classes, loader.getAvailableClasses<Base>().size());
+  }
+}
+
+TEST(ClassLoaderTest, concurrentLoadsRegisterWithTheirOwnLibrary) {
+  std::thread loading_thread(std::bind(&loadAndCheckClasses, LIBRARY_1, 5u));
+  loadAndCheckClasses(LIBRARY_2, 4u);
+  loading_thread.join();
+  ASSERT_FALSE(class_loader::impl::hasANonPurePluginLibraryBeenOpened());
+}
+
+#ifdef __ELF__
+// Note: The static registry is only available with ELF toolchains
+class StaticRobot : public Base
+{
+public:
+  virtual void saySomething() {std::cout << "Beep boop" << std::endl;}
+};
+
+class StaticParrot : public Base
+{
+public:
+  virtual void saySomething() {std::cout << "Squawk" << std::endl;}
+};
+
+CLASS_LOADER_REGISTER_STATIC_CLASS(StaticRobot, Base)
+CLASS_LOADER_REGISTER_STATIC_CLASS(StaticParrot, Base)
+
+TEST(StaticClassLoaderTest, basicCreate) {
+  class_loader::StaticClassLoader loader;
+  std::vector<std::string> classes = loader.getAvailableClasses<Base>();
+  ASSERT_EQ(2u, classes.size());
+  ASSERT_TRUE(loader.isClassAvailable<Base>("StaticRobot"));
+  ASSERT_TRUE(loader.isClassAvailable<Base>("StaticParrot"));
+  ASSERT_FALSE(loader.isClassAvailable<Base>("Robot"));
+  ASSERT_TRUE(loader.getAvailableClasses<InvalidBase>().empty());
+
+  loader.createSharedInstance<Base>("StaticRobot")->saySomething();
+  loader.createUniqueInstance<Base>("StaticParrot")->saySomething();
+  ASSERT_THROW(loader.createSharedInstance<Base>("Robot"), class_loader::CreateClassException);
+  ASSERT_THROW(
+    loader.createUniqueInstance<InvalidBase>("StaticRobot"), class_loader::CreateClassException);
+
+  // Nothing went through the plugin system
+  ASSERT_FALSE(class_loader::impl::hasANonPurePluginLibraryBeenOpened());
+}
+#endif
+
 TEST(ClassLoaderTest, loadRefCountingNonLazy) {
   try {
     class_loader::ClassLoader loader1(LIBRARY_1, false);
@@ -318,6 +987,319 @@ TEST(MultiClassLoaderTest, noWarningOnLazyLoad) {
   SUCCEED();
 }
 
+TEST(MultiClassLoaderTest, classesGoneAfterUnload) {
+  class_loader::MultiLibraryClassLoader loader(false);
+  loader.loadLibrary(LIBRARY_1);
+  loader.loadLibrary(LIBRARY_2);
+  loader.createInstance<Base>("Cat")->saySomething();
+  loader.createInstance<Base>("Robot")->saySomething();
+
+  ASSERT_EQ(0, loader.unloadLibrary(LIBRARY_1));
+  EXPECT_THROW(loader.createInstance<Base>("Cat"), class_loader::CreateClassException);
+  loader.createInstance<Base>("Robot")->saySomething();
+
+  loader.loadLibrary(LIBRARY_1);
+  loader.createInstance<Base>("Cat")->saySomething();
+}
+
+TEST(MultiClassLoaderTest, loadLibraries) {
+  try {
+    class_loader::MultiLibraryClassLoader loader(false);
+    loader.loadLibraries({LIBRARY_1, LIBRARY_2, LIBRARY_1});
+    std::vector<std::string> libraries = loader.getRegisteredLibraries();
+    ASSERT_EQ(2u, libraries.size());
+    ASSERT_TRUE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+    ASSERT_TRUE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_2));
+    loader.createInstance<Base>("Cat")->saySomething();
+    loader.createInstance<Base>("Robot")->saySomething();
+  } catch (class_loader::ClassLoaderException & e) {
+    FAIL() << "ClassLoaderException: " << e.what() << "\n";
+  }
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_2));
+}
+
+TEST(MultiClassLoaderTest, createSharedInstances) {
+  class_loader::MultiLibraryClassLoader loader(false);
+  loader.loadLibraries({LIBRARY_1, LIBRARY_2});
+  std::vector<std::shared_ptr<Base>> objs =
+    loader.createSharedInstances<Base>({"Robot", "Cat", "Alien"}, {1, 2, 1}, 2);
+  ASSERT_EQ(4u, objs.size());
+  for (auto & obj : objs) {
+    obj->saySomething();
+  }
+  objs.clear();
+
+  EXPECT_THROW(
+    loader.createSharedInstances<Base>({"Cat", "Bear"}), class_loader::CreateClassException);
+}
+
+TEST(MultiClassLoaderTest, pluginCreatesPluginsInItsConstructor) {
+  // The first creation indexes the library under an exclusive lock, which must not be held while
+  // the constructor creates the other plugins
+  class_loader::MultiLibraryClassLoader loader(true);
+  loader.loadLibrary(LIBRARY_1);
+  std::function<std::shared_ptr<Base>(std::string)> create = [&loader](std::string class_name) {
+      return loader.createSharedInstance<Base>(class_name);
+    };
+  std::shared_ptr<Base> pack = loader.createSharedInstanceWithArgs<Base>("Pack", create);
+  pack->saySomething();
+  loader.createSharedInstanceWithArgs<Base>("Pack", create)->saySomething();
+}
+
+TEST(MultiClassLoaderTest, warmUp) {
+  class_loader::MultiLibraryClassLoader loader(true);
+  loader.loadLibrary(LIBRARY_1);
+  loader.loadLibrary(LIBRARY_2);
+  loader.warmUp<Base>({"Cat", "Robot", "Dog"}, true).get();
+  ASSERT_TRUE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+  ASSERT_TRUE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_2));
+  loader.createSharedInstance<Base>("Cat")->saySomething();
+  loader.createSharedInstance<Base>("Robot")->saySomething();
+
+  EXPECT_THROW(loader.warmUp<Base>({"Bear"}), class_loader::CreateClassException);
+}
+
+TEST(MultiClassLoaderTest, loadLibrariesStopsAtFailure) {
+  class_loader::MultiLibraryClassLoader loader(false);
+  EXPECT_THROW(
+    loader.loadLibraries({LIBRARY_1, "libDoesNotExist.so", LIBRARY_2}),
+    class_loader::LibraryLoadException);
+  std::vector<std::string> libraries = loader.getRegisteredLibraries();
+  ASSERT_EQ(1u, libraries.size());
+  ASSERT_EQ(LIBRARY_1, libraries[0]);
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_2));
+}
+
+TEST(MultiClassLoaderTest, loadLibrariesInDependencyOrder) {
+  class_loader::MultiLibraryClassLoader loader(false);
+  class_loader::LibraryLoadReport report =
+    loader.loadLibrariesInDependencyOrder({LIBRARY_2, LIBRARY_1}, {{LIBRARY_2, {LIBRARY_1}}}, 2);
+  ASSERT_EQ(2u, report.libraries.size());
+  ASSERT_EQ(LIBRARY_1, report.libraries[0].library_path);
+  ASSERT_EQ(LIBRARY_2, report.libraries[1].library_path);
+  ASSERT_EQ(std::vector<std::string>({LIBRARY_1}), report.libraries[1].dependencies);
+  EXPECT_GE(report.libraries[1].start_time_ns, report.libraries[0].finish_time_ns);
+  EXPECT_EQ(std::vector<std::string>({LIBRARY_1, LIBRARY_2}), report.critical_path);
+  EXPECT_LE(report.critical_path_time_ns, report.total_time_ns);
+  loader.createInstance<Base>("Cat")->saySomething();
+  loader.createInstance<Base>("Robot")->saySomething();
+
+#ifdef __linux__
+  std::vector<std::string> needed_libraries = class_loader::impl::getNeededLibraries(LIBRARY_1);
+  EXPECT_TRUE(
+    std::any_of(
+      needed_libraries.begin(), needed_libraries.end(), [](const std::string & name) {
+        return 0 == name.find("libclass_loader");
+      }));
+#endif
+}
+
+TEST(MultiClassLoaderTest, loadLibrariesWithCyclicDependencies) {
+  class_loader::MultiLibraryClassLoader loader(false);
+  EXPECT_THROW(
+    loader.loadLibrariesInDependencyOrder(
+      {LIBRARY_1, LIBRARY_2}, {{LIBRARY_1, {LIBRARY_2}}, {LIBRARY_2, {LIBRARY_1}}}),
+    class_loader::LibraryLoadException);
+  ASSERT_TRUE(loader.getRegisteredLibraries().empty());
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+}
+
+#ifndef _WIN32
+TEST(MultiClassLoaderTest, reloadLibrary) {
+  const int reload_flags = class_loader::LIBRARY_LOAD_DEFAULT;
+  class_loader::MultiLibraryClassLoader loader(false);
+  loader.loadLibrary(LIBRARY_1);
+  std::shared_ptr<Base> old_cat = loader.createSharedInstance<Base>("Cat");
+
+  loader.reloadLibrary(LIBRARY_1, reload_flags);
+  ASSERT_EQ(std::vector<std::string>({LIBRARY_1}), loader.getRegisteredLibraries());
+  std::shared_ptr<Base> new_cat = loader.createSharedInstance<Base>("Cat");
+  ASSERT_TRUE(loader.isClassAvailable<Base>("Dog"));
+
+  // The old build is retired once its last instance is gone, the new one keeps working
+  ASSERT_TRUE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+  old_cat->saySomething();
+  old_cat.reset();
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(LIBRARY_1));
+  new_cat->saySomething();
+  new_cat.reset();
+  loader.createSharedInstance<Base>("Dog")->saySomething();
+
+  // A second reload replaces the snapshot, which is removed along with its class loader
+  loader.reloadLibrary(LIBRARY_1, reload_flags);
+  loader.createSharedInstance<Base>("Cat")->saySomething();
+  loader.unloadLibrary(LIBRARY_1);
+  ASSERT_TRUE(loader.getRegisteredLibraries().empty());
+}
+#endif
+
+#ifndef _WIN32
+typedef std::shared_ptr<std::vector<int>> Transcript;
+
+TEST(MultiClassLoaderTest, reloadNewBuildOfLibrary) {
+  // Note: Works on a copy of the first build, which the second build replaces like a rebuild does
+  const std::string library_path = class_loader::impl::createLibrarySnapshot(RELOAD_LIBRARY_1);
+  Transcript transcript = std::make_shared<std::vector<int>>();
+  {
+    class_loader::MultiLibraryClassLoader loader(false);
+    loader.loadLibrary(library_path);
+    std::shared_ptr<Base> old_revision =
+      loader.createSharedInstanceWithArgs<Base>("Revision", transcript);
+
+    const std::string build_path = class_loader::impl::createLibrarySnapshot(RELOAD_LIBRARY_2);
+    ASSERT_EQ(0, std::rename(build_path.c_str(), library_path.c_str()));
+    loader.reloadLibrary(library_path);
+    ASSERT_EQ(std::vector<std::string>({library_path}), loader.getRegisteredLibraries());
+
+    // The new instances come from the factories of the snapshot of the second build
+    class_loader::impl::AbstractMetaObjectBase * factory =
+      class_loader::impl::findFactory(typeid(Base(Transcript)).name(), "Revision");
+    ASSERT_TRUE(factory != nullptr);
+    const std::string snapshot_path = factory->getAssociatedLibraryPath();
+    EXPECT_NE(library_path, snapshot_path);
+    EXPECT_TRUE(class_loader::impl::isLibraryLoadedByAnybody(snapshot_path));
+    std::shared_ptr<Base> new_revision =
+      loader.createSharedInstanceWithArgs<Base>("Revision", transcript);
+
+    old_revision->saySomething();
+    new_revision->saySomething();
+    EXPECT_EQ(std::vector<int>({1, 2}), *transcript);
+  }
+  std::remove(library_path.c_str());
+}
+#endif
+
+#ifdef __linux__
+TEST(MultiClassLoaderTest, reloadLibraryExportingSymbols) {
+  const std::string library_path =
+    class_loader::impl::createLibrarySnapshot(RELOAD_LIBRARY_EXPORTED);
+  Transcript transcript = std::make_shared<std::vector<int>>();
+  {
+    class_loader::MultiLibraryClassLoader loader(false);
+    loader.loadLibrary(library_path);
+    EXPECT_FALSE(
+      class_loader::impl::getSymbolsInterposedByLibrary(library_path, library_path).empty());
+    EXPECT_TRUE(
+      class_loader::impl::getSymbolsInterposedByLibrary(RELOAD_LIBRARY_1, library_path).empty());
+
+    // The new build would call getRevision() of the loaded one, so the loaded one is kept
+    EXPECT_THROW(loader.reloadLibrary(library_path), class_loader::LibraryLoadException);
+    ASSERT_EQ(std::vector<std::string>({library_path}), loader.getRegisteredLibraries());
+    class_loader::impl::AbstractMetaObjectBase * factory =
+      class_loader::impl::findFactory(typeid(Base(Transcript)).name(), "Revision");
+    ASSERT_TRUE(factory != nullptr);
+    EXPECT_EQ(library_path, factory->getAssociatedLibraryPath());
+    loader.createSharedInstanceWithArgs<Base>("Revision", transcript)->saySomething();
+    EXPECT_EQ(std::vector<int>({1}), *transcript);
+  }
+  std::remove(library_path.c_str());
+}
+#endif
+
+#ifndef _WIN32
+// Note: Keeps LIBRARY_2 resident for the rest of the process, so this runs last
+TEST(ClassLoaderGraveyardTest, reviveFactoriesOfResidentLibrary) {
+  class_loader::impl::resetStatistics();
+  {
+    class_loader::ClassLoader loader(LIBRARY_2, false);
+    // Once closed by the ClassLoader, the library stays in memory without registering again
+    void * handle = dlopen(LIBRARY_2.c_str(), RTLD_NOW | RTLD_NOLOAD | RTLD_NODELETE);
+    ASSERT_TRUE(handle != nullptr);
+    dlclose(handle);
+  }
+
+  for (int c = 0; c < 3; ++c) {
+    class_loader::ClassLoader loader(LIBRARY_2, false);
+    ASSERT_EQ(4u, loader.getAvailableClasses<Base>().size());
+    loader.createInstance<Base>("Robot")->saySomething();
+  }
+
+#ifndef CLASS_LOADER_DISABLE_STATISTICS
+  for (auto & it : class_loader::impl::getStatistics().libraries) {
+    if (it.library_path == LIBRARY_2) {
+      EXPECT_EQ(4u, it.load_count);
+      EXPECT_EQ(12u, it.graveyard_revival_count);
+    }
+  }
+#endif
+}
+#endif
+
+#ifdef __linux__
+void removeDirectory(const std::string & directory)
+{
+  DIR * dir = opendir(directory.c_str());
+  if (nullptr == dir) {
+    return;
+  }
+  while (struct dirent * entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      std::string path = directory + "/" + name;
+      if (DT_DIR == entry->d_type) {
+        removeDirectory(path);
+      } else {
+        std::remove(path.c_str());
+      }
+    }
+  }
+  closedir(dir);
+  rmdir(directory.c_str());
+}
+
+TEST(ClassLoaderCatalogTest, listsClassesOfRecordedLibraryWithoutLoading) {
+  // Note: Works on a copy of LIBRARY_1, which is then modified to invalidate its catalog entry
+  std::string library_file;
+  {
+    class_loader::ClassLoader loader(LIBRARY_1, false);
+    void * handle = dlopen(LIBRARY_1.c_str(), RTLD_NOW | RTLD_NOLOAD);
+    ASSERT_TRUE(handle != nullptr);
+    struct link_map * library_map = nullptr;
+    ASSERT_EQ(0, dlinfo(handle, RTLD_DI_LINKMAP, &library_map));
+    library_file = library_map->l_name;
+    dlclose(handle);
+  }
+  char directory_template[] = "/tmp/class_loader_catalog_test_XXXXXX";
+  ASSERT_TRUE(mkdtemp(directory_template) != nullptr);
+  const std::string directory = directory_template;
+  const std::string library_copy = directory + "/" + LIBRARY_1;
+  {
+    std::ifstream library(library_file.c_str(), std::ios::binary);
+    std::ofstream copy(library_copy.c_str(), std::ios::binary);
+    copy << library.rdbuf();
+  }
+
+  class_loader::impl::setPluginCatalogDirectory(directory + "/catalog");
+  ASSERT_FALSE(class_loader::impl::hasLibraryManifest(library_copy));
+  {
+    class_loader::ClassLoader loader(library_copy, true);
+    loader.createInstance<Base>("Cat")->saySomething();
+  }
+  ASSERT_FALSE(class_loader::impl::isLibraryLoadedByAnybody(library_copy));
+  ASSERT_TRUE(class_loader::impl::hasLibraryManifest(library_copy));
+  {
+    class_loader::ClassLoader loader(library_copy, true);
+    std::vector<std::string> classes = loader.getAvailableClasses<Base>();
+    std::sort(classes.begin(), classes.end());
+    ASSERT_EQ(std::vector<std::string>({"Cat", "Cow", "Dog", "Duck", "Sheep"}), classes);
+    ASSERT_TRUE(loader.isClassAvailable<Base>("Dog"));
+    ASSERT_FALSE(loader.isClassAvailable<InvalidBase>("Dog"));
+    ASSERT_FALSE(loader.isLibraryLoadedByAnyClassloader());
+  }
+
+  // Once the library changes, its entry is ignored
+  {
+    std::ofstream copy(library_copy.c_str(), std::ios::binary | std::ios::app);
+    copy.put('\0');
+  }
+  ASSERT_FALSE(class_loader::impl::hasLibraryManifest(library_copy));
+
+  class_loader::impl::setPluginCatalogDirectory("");
+  removeDirectory(directory);
+}
+#endif
+
 // Run all the tests that were declared with TEST()
 int main(int argc, char ** argv)
 {